@@ -20,6 +20,7 @@
 #define ENTITY_G3_FILE_H
 
 #include <QString>
+#include <QIODevice>
 #include <KTemporaryFile>
 #include <KMimeType>
 
@@ -35,7 +36,8 @@ namespace KIO
      * a file meant to be uploaded during the creation of a new item of type
      * 'photo' or 'movie'. 
      * Note that the wrapper does _not_ contain the file content itself, but
-     * only some meta information
+     * only some meta information. The content is either read from a local file
+     * or from an open device (which must provide exactly 'size' bytes).
      * @author Christian Reiner
      */
     class G3File
@@ -44,12 +46,18 @@ namespace KIO
         const QString        m_filename;
         const KMimeType::Ptr m_mimetype;
         const QString        m_filepath;
+        QIODevice* const     m_device;
+        const qint64         m_size;
       public:
         inline G3File ( const QString& filename, const KMimeType::Ptr& mimetype, const QString& filepath )
-                      : m_filename(filename), m_mimetype(mimetype), m_filepath(filepath) { }
+                      : m_filename(filename), m_mimetype(mimetype), m_filepath(filepath), m_device(NULL), m_size(-1) { }
+        inline G3File ( const QString& filename, const KMimeType::Ptr& mimetype, QIODevice* device, qint64 size )
+                      : m_filename(filename), m_mimetype(mimetype), m_device(device), m_size(size) { }
         inline const QString&       filename() const { return m_filename; }
         inline const KMimeType::Ptr mimetype() const { return m_mimetype; }
         inline const QString&       filepath() const { return m_filepath; }
+        inline QIODevice*           device()   const { return m_device; }
+        inline qint64               size()     const { return m_size; }
     }; // class G3File
   } // namespace Gallery3
 } // namespace KIO
@@ -18,6 +18,10 @@
 #include <QObject>
 #include <QCryptographicHash>
 #include <QVariant>
+#include <QDataStream>
+#include <QDateTime>
+#include <QSet>
+#include <QtAlgorithms>
 #include <qjson/parser.h>
 #include <qjson/serializer.h>
 #include <qjson/qobjecthelper.h>
@@ -30,12 +34,27 @@
 #include "utility/exception.h"
 #include "protocol/kio_protocol_gallery3.h"
 #include "gallery3/g3_backend.h"
+#include "gallery3/g3_cache.h"
 #include "gallery3/g3_request.h"
 #include "entity/g3_item.h"
 
 using namespace KIO;
 using namespace KIO::Gallery3;
 
+// names of the url tokens inside the entity of an items description, by G3Item::Url
+// note: the rest url is not part of the entity but a top level attribute
+static const char* const urlTokens[G3Item::URL_COUNT] =
+{
+  "url", "album_cover", "web_url", "web_url_public", "file_url", "file_url_public",
+  "resize_url", "resize_url_public", "thumb_url", "thumb_url_public"
+};
+
+// tokens of the entity decoded into the private members, not kept in the serialized description
+static const char* const decodedTokens[] =
+{
+  "id", "name", "description", "created", "updated", "can_edit", "file_size", "mime_type", "type", "parent"
+};
+
 /*!
  * G3Item* const G3Item::instantiate ( G3Backend* const backend, const QVariantMap& attributes )
  * @brief Instantiates an item based in the attributes provided 
@@ -99,44 +118,152 @@ G3Item* const G3Item::instantiate ( G3Backend* const backend, const QVariantMap&
  * @author Christian Reiner
  */
 G3Item::G3Item ( const G3Type type, G3Backend* const backend, const QVariantMap& attributes )
-  : m ( new G3Item::Members(type,backend,attributes) )
+  : m ( new (backend->itemPool().allocate()) G3Item::Members(type,backend) )
 {
   KDebug::Block block ( "G3Item::G3Item" );
   kDebug() << "(<type> <backend> <attributes>)" << type.toString() << backend->toPrintout() << QStringList(attributes.keys()).join(QLatin1String(","));
-  // store most important entity tokens directly as strings
-  // a few values stored type-strict for later convenience
-  m->id         = attributeMapToken ( QLatin1String("entity"), QLatin1String("id"),   QVariant::UInt,   TRUE  ).toUInt();
-  m->name       = attributeMapToken ( QLatin1String("entity"), QLatin1String("name"), QVariant::String, FALSE ).toString();
+  describe ( attributes );
+  // set parent and pushd into parent
+  if ( 0==m->parentId )
+  {
+    m->parent = NULL;
+    m->backend->pushItem ( this );
+  }
+  else
+  {
+    m->parent   = m->backend->item ( m->parentId );
+    kDebug() << "caching item" << this->toPrintout() << "in parent item" << m->parent->toPrintout();
+    m->parent->pushMember ( this );
+    m->backend->pushItem ( this );
+  } // else
+} // G3Item::G3Item
+
+/*!
+ * void G3Item::describe ( const QVariantMap& attributes )
+ * @brief Takes over the description of the item
+ * @param attributes the items technical description as retrieved from the remote Gallery3 system
+ * Decodes the frequently used tokens into typed members and keeps the rest
+ * serialized. The item is not linked into the hierarchy here.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::describe ( const QVariantMap& attributes )
+{
+  // decode the frequently used entity tokens once, typed
+  const QVariantMap entity = attributes.value(QLatin1String("entity")).toMap();
+  if ( ! entity.value(QLatin1String("id")).canConvert(QVariant::UInt) )
+    throw Exception ( Error(ERR_SLAVE_DEFINED),
+                      i18n("mandatory attribute token '%1|%2' does not exist or does not have requested type").arg("entity").arg("id") );
+  m->id          = entity.value(QLatin1String("id")).toUInt();
+  m->name        = entity.value(QLatin1String("name")).toString();
+  m->size        = (G3Type::ALBUM==m->type.toInt()) ? 0 : entity.value(QLatin1String("file_size")).toLongLong();
+  m->created     = entity.value(QLatin1String("created")).toUInt();
+  m->updated     = entity.value(QLatin1String("updated")).toUInt();
+  m->canEdit     = entity.value(QLatin1String("can_edit")).toBool();
+  m->fetched     = QDateTime::currentDateTime().toTime_t();
+  m->description = entity.value(QLatin1String("description")).toString();
+  // the urls are kept as templates where possible, they are not part of the serialized description
+  QVariantMap rest    = attributes;
+  QVariantMap tokens  = entity;
+  setUrl ( REST, attributes.value(QLatin1String("url")).toString() );
+  rest.remove ( QLatin1String("url") );
+  for ( int which=COVER; which<URL_COUNT; which++ )
+  {
+    setUrl ( Url(which), entity.value(QLatin1String(urlTokens[which])).toString() );
+    tokens.remove ( QLatin1String(urlTokens[which]) );
+  }
+  // neither are the tokens decoded already, attributes() inserts them again
+  for ( uint pos=0; pos<sizeof(decodedTokens)/sizeof(decodedTokens[0]); pos++ )
+    tokens.remove ( QLatin1String(decodedTokens[pos]) );
+  rest.insert ( QLatin1String("entity"), tokens );
+  // the list of members is required to build the hierarchy
+  if ( attributes.value(QLatin1String("members")).canConvert(QVariant::List) )
+  {
+    m->hasMembers = TRUE;
+    // only the ids are kept, the urls can be synthesized when required
+    const QVariantList members = attributes.value(QLatin1String("members")).toList();
+    QVector<g3index> ids;
+    ids.reserve ( members.count() );
+    foreach ( const QVariant& member, members )
+      ids << idFromUrl ( member.toString() );
+    sortIds ( ids );
+    album()->memberIds = ids;
+    m->album->missing.clear ( );
+  }
+  // everything else is kept in serialized form and only decoded on demand
+  rest.remove ( QLatin1String("members") );
+  m->blob.clear ( );
+  QDataStream stream ( &m->blob, QIODevice::WriteOnly );
+  stream.setVersion ( QDataStream::Qt_4_7 );
+  stream << rest;
+  // a rough estimate of the memory held, the backend keeps the sum within a budget
+  m->footprint = sizeof(G3Item) + sizeof(G3Item::Members) + m->blob.size()
+               + sizeof(QChar) * ( m->name.size() + m->description.size() );
+  if ( NULL!=m->album )
+    m->footprint += sizeof(G3Item::Album) + sizeof(g3index) * m->album->memberIds.size();
   // set the items mimetype
-  QString mimetype_name = attributeMapToken ( QLatin1String("entity"), QLatin1String("mime_type"), QVariant::String, FALSE ).toString();
+  QString mimetype_name = entity.value(QLatin1String("mime_type")).toString();
   if ( ! mimetype_name.isEmpty() )
-    m->mimetype = KMimeType::mimeType(mimetype_name);
+    m->mimetype = m->backend->mimetype ( mimetype_name );
   else
-    switch ( type.toInt() )
+    switch ( m->type.toInt() )
     {
       case G3Type::ALBUM:
-        m->mimetype = KMimeType::mimeType ( QLatin1String("inode/directory") );
+        m->mimetype = m->backend->mimetype ( QLatin1String("inode/directory") );
         break;
       default:
         m->mimetype = KMimeType::defaultMimeTypePtr ( );
     } // switch type
-  // set parent and pushd into parent
-  QString parent_url = attributeMapToken ( QLatin1String("entity"), QLatin1String("parent"), QVariant::String, FALSE ).toString();
-  if ( parent_url.isEmpty() )
-  {
+  const QString parent_url = entity.value(QLatin1String("parent")).toString();
+  m->parentId = parent_url.isEmpty() ? 0 : idFromUrl ( parent_url );
+  // the memoised entry is outdated
+  m->entry.clear ( );
+  m->entryUpdated = 0;
+} // G3Item::describe
+
+/*!
+ * void G3Item::refresh ( const QVariantMap& attributes )
+ * @brief Updates the item in place from a fresh description
+ * @param attributes the items technical description as retrieved from the remote Gallery3 system
+ * The item keeps its identity and all its members that are still described:
+ * it is relinked into its parent, since name or even parent might have
+ * changed, and members not described anymore are deleted.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::refresh ( const QVariantMap& attributes )
+{
+  KDebug::Block block ( "G3Item::refresh" );
+  kDebug() << "(<this>)" << toPrintout();
+  const QVariantMap entity = attributes.value(QLatin1String("entity")).toMap();
+  if ( m->id!=entity.value(QLatin1String("id")).toUInt() )
+    throw Exception ( Error(ERR_INTERNAL),
+                      i18n("attempt to describe item with id '%1' by the description of another item").arg(m->id) );
+  const int     footprint = m->footprint;
+  const g3index parentId  = m->parentId;
+  // the name might change, so the item is relinked into its parent
+  if ( NULL!=m->parent )
+    m->parent->popMember ( this );
+  describe ( attributes );
+  if ( 0==m->parentId )
     m->parent = NULL;
-    m->backend->pushItem ( this );
-  }
   else
   {
-    KUrl url = KUrl ( parent_url );
-    g3index id = QVariant(url.fileName()).toInt();
-    m->parent = m->backend->item ( id );
-    kDebug() << "caching item" << this->toPrintout() << "in parent item" << m->parent->toPrintout();
+    // a changed parent means the item has been moved
+    if ( NULL==m->parent || parentId!=m->parentId )
+    {
+      if ( NULL!=m->parent )
+        m->parent->removeMemberId ( m->id );
+      m->parent = m->backend->item ( m->parentId );
+      m->parent->addMemberId ( m->id );
+    }
     m->parent->pushMember ( this );
-    m->backend->pushItem ( this );
-  } // else
-} // G3Item::G3Item
+  }
+  // members still described are kept
+  if ( m->hasMembers )
+    mergeMembers ( FALSE );
+  m->backend->resizeItem ( this, footprint );
+} // G3Item::refresh
 
 /*!
  * G3Item::~G3Item()
@@ -157,20 +284,146 @@ G3Item::~G3Item()
     m->parent->popMember ( this );
   }
   // delete all members registered inside this item
-  while ( ! m->members.isEmpty() )
+  while ( NULL!=m->album && ! m->album->members.isEmpty() )
   {
-    QHash<g3index,G3Item*>::const_iterator member = m->members.constBegin ( );
+    QHash<g3index,G3Item*>::const_iterator member = m->album->members.constBegin ( );
     kDebug() << "deleting member" << member.value()->toPrintout();
     delete member.value ( );
   }
   // remove this item from the backends catalog
   m->backend->popItem ( m->id );
-  // delete private members
-  delete m;
+  // delete private members, they have been taken from the pool of the backend
+  G3Backend* const backend = m->backend;
+  m->~Members ( );
+  backend->itemPool().release ( m );
 } // G3Item::~G3Item
 
 //==========
 
+/*!
+ * G3Item::Album* G3Item::album ( )
+ * @brief Provides the containers holding the members of an item
+ * @return the containers, allocated when first required
+ * Items without members (photos, movies, ...) never allocate them.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+G3Item::Album* G3Item::album ( )
+{
+  if ( NULL==m->album )
+    m->album = new G3Item::Album ( );
+  return m->album;
+} // G3Item::album
+
+/*!
+ * QVariantMap G3Item::attributes ( ) const
+ * @brief Decodes the items complete technical description
+ * @return the description as retrieved from the remote Gallery3 system
+ * The description is kept in serialized form only, since most of it is never
+ * used. It is decoded each time a rarely used attribute is requested.
+ * The urls and the tokens decoded into members are not part of the serialized
+ * form, they are added again.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+QVariantMap G3Item::attributes ( ) const
+{
+  QVariantMap attributes;
+  QDataStream stream ( m->blob );
+  stream.setVersion ( QDataStream::Qt_4_7 );
+  stream >> attributes;
+  // the urls are held separately
+  QVariantMap entity = attributes.value(QLatin1String("entity")).toMap();
+  attributes.insert ( QLatin1String("url"), urlString(REST) );
+  for ( int which=COVER; which<URL_COUNT; which++ )
+    if ( ! m->urls[which].isEmpty() )
+      entity.insert ( QLatin1String(urlTokens[which]), urlString(Url(which)) );
+  // so are the tokens decoded into members
+  entity.insert ( QLatin1String("id"),          m->id );
+  entity.insert ( QLatin1String("name"),        m->name );
+  entity.insert ( QLatin1String("description"), m->description );
+  entity.insert ( QLatin1String("created"),     m->created );
+  entity.insert ( QLatin1String("updated"),     m->updated );
+  entity.insert ( QLatin1String("can_edit"),    m->canEdit );
+  entity.insert ( QLatin1String("type"),        m->type.toString() );
+  if ( G3Type::ALBUM!=m->type.toInt() )
+  {
+    entity.insert ( QLatin1String("file_size"), m->size );
+    entity.insert ( QLatin1String("mime_type"), m->mimetype->name() );
+  }
+  if ( 0!=m->parentId )
+    entity.insert ( QLatin1String("parent"),    memberUrl(m->parentId) );
+  attributes.insert ( QLatin1String("entity"), entity );
+  return attributes;
+} // G3Item::attributes
+
+/*!
+ * const KUrl G3Item::url ( Url which, bool strict ) const
+ * @brief Provides one of the urls describing the item
+ * @param  which  the url requested
+ * @param  strict insist on existance or throw exception instead
+ * @return        the requested url, empty if it does not exist
+ * @see G3Item
+ * @author Christian Reiner
+ */
+const KUrl G3Item::url ( Url which, bool strict ) const
+{
+  if ( strict && m->urls[which].isEmpty() )
+    throw Exception ( Error(ERR_SLAVE_DEFINED),
+                      i18n("mandatory url attribute [%1] of item '%2' does not exist").arg(which).arg(m->id) );
+  return KUrl ( urlString(which) );
+} // G3Item::url
+
+/*!
+ * const QString G3Item::urlString ( Url which ) const
+ * @brief Expands one of the urls describing the item
+ * @param  which the url requested
+ * @return       the requested url as a string, empty if it does not exist
+ * @see G3Item::setUrl
+ * @see G3Item
+ * @author Christian Reiner
+ */
+const QString G3Item::urlString ( Url which ) const
+{
+  if ( 0>m->idAt[which] )
+    return m->urls[which];
+  return QString(m->urls[which]).insert ( m->idAt[which], QString::number(m->id) );
+} // G3Item::urlString
+
+/*!
+ * void G3Item::setUrl ( Url which, const QString& url )
+ * @brief Stores one of the urls describing the item
+ * @param which the url to be stored
+ * @param url   the url as specified in the items description
+ * Most urls differ from item to item only by the items id, for example
+ * 'http://gallery.some.server/rest/data/666?size=thumb'. Those are stored as
+ * a template, the url without the id, interned by the backend and shared by
+ * all items, plus the position the id has to be inserted at.
+ * Only an id forming a complete path component is considered.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::setUrl ( Url which, const QString& url )
+{
+  const QString id = QString::number ( m->id );
+  int pos = url.lastIndexOf ( id );
+  while ( 0<pos )
+  {
+    const int end = pos + id.size ( );
+    if (    pos<=0x7fff
+         && QLatin1Char('/')==url.at(pos-1)
+         && ( url.size()==end || QLatin1Char('?')==url.at(end) || QLatin1Char('/')==url.at(end) ) )
+    {
+      m->urls[which] = m->backend->intern ( QString(url).remove(pos,id.size()) );
+      m->idAt[which] = pos;
+      return;
+    }
+    pos = url.lastIndexOf ( id, pos-1 );
+  } // while
+  m->urls[which] = url;
+  m->idAt[which] = -1;
+} // G3Item::setUrl
+
 /*!
  * const QVariant G3Item::attributeToken ( const QString& attribute, QVariant::Type type, bool strict ) const
  * @brief Extracts an attributes from the technical item description
@@ -184,16 +437,26 @@ G3Item::~G3Item()
  * requested type. In case the attribute does not exist an empty value is
  * returned, except if the strict parameter was set to TRUE, in that case an
  * exception is thrown. 
+ * Note that this decodes the items complete description, the frequently used
+ * attributes are available through typed accessors instead.
  * @see G3Item
  * @author Christian Reiner
  */
 const QVariant G3Item::attributeToken ( const QString& attribute, QVariant::Type type, bool strict ) const
 {
   kDebug() << "(<attribute> <type> <strict>)" << attribute << type << strict;
-  if (   m->attributes.contains (attribute)
-      && m->attributes[attribute].canConvert(type) )
+  // the list of members is held decoded
+  if ( m->hasMembers && QLatin1String("members")==attribute && QVariant::List==type )
+  {
+    QVariantList urls;
+    foreach ( g3index id, m->album->memberIds )
+      urls << memberUrl ( id );
+    return QVariant ( urls );
+  }
+  QVariant value = attributes().value ( attribute );
+  if ( value.canConvert(type) )
     // value exists and is convertable
-    return m->attributes[attribute];
+    return value;
   else if ( ! strict )
     // value does not exist but an empty instance will be accepted anyway
     return QVariant(type);
@@ -261,18 +524,24 @@ const QVariant G3Item::attributeMapToken ( const QString& attribute, const QStri
  * @brief Accepts a new member item
  * @param item: item to be accepted as a new member inside this item
  * Accepts a new item as member inside the current album. 
+ * Whilst the album is being listed the new member is published right away.
  * @see G3Item
  * @author Christian Reiner
  */
 void G3Item::pushMember ( G3Item* item )
 {
   kDebug() << "(<this> <item>)" << toPrintout() << item->toPrintout();
-  if ( m->members.contains(item->id()) )
+  album ( );
+  if ( m->album->members.contains(item->id()) )
     throw Exception ( Error(ERR_INTERNAL),
                       i18n("attempt to register item with id '%1' that already exists").arg(item->id()) );
   // all fine, store items
-  m->members.insert ( item->id(), item );
+  m->album->members.insert ( item->id(), item );
+  m->album->names.insert   ( item->name(), item );
+  m->album->missing.remove ( item->name() );
   item->m->parent = this;
+  if ( m->album->listing )
+    publishMember ( item );
 } // G3Item::pushMember
 
 /*!
@@ -304,16 +573,106 @@ G3Item* G3Item::popMember ( G3Item* item )
 G3Item* G3Item::popMember ( g3index id )
 {
   kDebug() << "(<this> <id>)" << toPrintout() << id;
-  if ( m->members.contains(id) )
+  if ( NULL!=m->album && m->album->members.contains(id) )
   {
-    G3Item* item = m->members[id];
-    m->members.remove ( id );
+    G3Item* item = m->album->members.take ( id );
+    // only drop the name index entry if it refers to this very item
+    if ( item==m->album->names.value(item->name()) )
+      m->album->names.remove ( item->name() );
     return item;
   }
   throw Exception ( Error(ERR_INTERNAL),
                     i18n("attempt to remove non-existing member item with id '%1'").arg(id) );
 } // G3Item::popMember
 
+/*!
+ * void G3Item::addMemberId ( g3index id )
+ * @brief Registers a member inside the items description
+ * @param id numeric id of the new member
+ * Patches the list of members as described by the remote Gallery3 system
+ * after a member has been created or moved into this item (album), so the
+ * item does not have to be retrieved again.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::addMemberId ( g3index id )
+{
+  kDebug() << "(<this> <id>)" << toPrintout() << id;
+  album ( );
+  QVector<g3index>::iterator it = qLowerBound ( m->album->memberIds.begin(), m->album->memberIds.end(), id );
+  if ( m->album->memberIds.end()==it || id!=*it )
+    m->album->memberIds.insert ( it, id );
+  // the name of the new member is not known yet
+  m->album->missing.clear ( );
+} // G3Item::addMemberId
+
+/*!
+ * void G3Item::removeMemberId ( g3index id )
+ * @brief Removes a member from the items description
+ * @param id numeric id of the member
+ * Patches the list of members as described by the remote Gallery3 system
+ * after a member has been deleted or moved out of this item (album).
+ * Note that the member object itself is not touched.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::removeMemberId ( g3index id )
+{
+  kDebug() << "(<this> <id>)" << toPrintout() << id;
+  if ( NULL==m->album )
+    return;
+  QVector<g3index>::iterator it = qBinaryFind ( m->album->memberIds.begin(), m->album->memberIds.end(), id );
+  if ( m->album->memberIds.end()!=it )
+    m->album->memberIds.erase ( it );
+} // G3Item::removeMemberId
+
+/*!
+ * void G3Item::evictMembers ( )
+ * @brief Deletes all member items present
+ * The ids of the members are kept, so the members are retrieved again when
+ * they are required next time. Used to keep a backend within its memory budget.
+ * @see G3Backend::evictItems
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::evictMembers ( )
+{
+  kDebug() << "(<this>)" << toPrintout();
+  // a member deleted removes itself from the list of members
+  while ( NULL!=m->album && ! m->album->members.isEmpty() )
+    delete m->album->members.constBegin().value();
+} // G3Item::evictMembers
+
+/*!
+ * bool G3Item::matches ( const QVariantMap& attributes ) const
+ * @brief Decides if a fresh description still describes the item
+ * @param  attributes the items description as retrieved from the remote system
+ * @return            TRUE if the item is still up to date, FALSE otherwise
+ * Compares the time of the last update. Since changes of the members of an
+ * album do not alter its 'updated' time the ids of the members are compared
+ * as well.
+ * @see G3Backend::revalidateItems
+ * @see G3Item
+ * @author Christian Reiner
+ */
+bool G3Item::matches ( const QVariantMap& attributes ) const
+{
+  const QVariantMap entity = attributes.value(QLatin1String("entity")).toMap();
+  if ( m->updated!=entity.value(QLatin1String("updated")).toUInt() )
+    return FALSE;
+  if ( ! m->hasMembers )
+    return TRUE;
+  const QVariantList members = attributes.value(QLatin1String("members")).toList();
+  if ( members.count()!=m->album->memberIds.count() )
+    return FALSE;
+  QVector<g3index> ids;
+  ids.reserve ( members.count() );
+  foreach ( const QVariant& member, members )
+    ids << idFromUrl ( member.toString() );
+  sortIds ( ids );
+  return ids==m->album->memberIds;
+} // G3Item::matches
+
 /*!
  * void G3Item::setParent ( G3Item* parent )
  * @brief Sets an items parent (album)
@@ -330,6 +689,63 @@ void G3Item::setParent ( G3Item* parent )
 
 //==========
 
+/*!
+ * G3Item* G3Item::findMember ( const QString& name )
+ * @brief Looks up a member item
+ * @param  name name of the requested item
+ * @return      pointer to the requested member item, NULL if there is no such member
+ * Like member(), but a missing member is not treated as an error. Names that
+ * have been looked up in vain are remembered, so clients probing for names
+ * like '.directory' or 'Thumbs.db' again and again cause no further requests.
+ * This is forgotten as soon as the list of members changes.
+ * The member is looked up in the name index, not by scanning all members.
+ * If it is not known yet only this single member is retrieved, the list of
+ * all members is completed later, when it is actually required.
+ * Items that cannot hold members, like images, simply have no such member.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+G3Item* G3Item::findMember ( const QString& name )
+{
+  kDebug() << "(<this> <name>)" << toPrintout() << name;
+  // items without members cannot hold the requested one
+  if ( ! m->hasMembers )
+    return NULL;
+  // maybe the member is known already
+  G3Item* item = m->album ? m->album->names.value(name,NULL) : NULL;
+  if ( NULL!=item )
+  {
+    m->backend->touchItem ( item );
+    return item;
+  }
+  if ( m->album && m->album->missing.contains(name) )
+    return NULL;
+  // resolve just this member instead of retrieving all its siblings
+  if (   m->hasMembers
+      && m->album->memberIds.count()!=m->album->members.count()
+      && m->backend->settings().readEntry("LazyPathResolution",TRUE) )
+  {
+    // note: the server might return several members with a similar name
+    QVector<g3index> ids;
+    foreach ( const QString& url, G3Request::g3GetMemberUrls(m->backend,m->id,name) )
+      ids << idFromUrl ( url );
+    retrieveMembers ( ids );
+  } // if
+  else
+    // make sure members have been retrieved
+    buildMemberItems ( );
+  // look for requested member
+  item = album()->names.value ( name, NULL );
+  if ( NULL==item )
+  {
+    kDebug() << "remembering name" << name << "as missing";
+    if ( m->album->missing.count()>=ITEM_MISSING_NAMES )
+      m->album->missing.clear ( );
+    m->album->missing.insert ( name );
+  }
+  return item;
+} // G3Item::findMember
+
 /*!
  * G3Item* G3Item::member ( const QString& name )
  * @brief Provides a member item
@@ -338,23 +754,18 @@ void G3Item::setParent ( G3Item* parent )
  * Requests an item object specified by its unique name. The item will be
  * created (retrieved) if it does not (yet) exist locally or an exception will
  * be thrown in case the item does not exist inside the remote Gallery3 system.
+ * @see G3Item::findMember
  * @see G3Item
  * @author Christian Reiner
  */
 G3Item* G3Item::member ( const QString& name )
 {
-  KDebug::Block block ( "G3Item::member" );
-  kDebug() << "(<this> <name>)" << toPrintout() << name;
-  // make sure members have been retrieved
-  buildMemberItems ( );
-  // look for requested member
-  QHash<g3index,G3Item*>::const_iterator member;
-  for ( member=m->members.constBegin(); member!=m->members.constEnd(); member++ )
-    if ( name==member.value()->name() )
-      return member.value();
+  G3Item* item = findMember ( name );
+  if ( NULL!=item )
+    return item;
   // no success, no matching member found
   throw Exception ( Error(ERR_DOES_NOT_EXIST), name );
-} // G3Item::getMember
+} // G3Item::member
 
 /*!
  * G3Item* G3Item::member ( g3index id )
@@ -374,10 +785,10 @@ G3Item* G3Item::member ( g3index id )
   // make sure members have been retrieved
   buildMemberItems ( );
   // look for requested member
-  if ( m->members.contains(id) )
+  if ( m->album->members.contains(id) )
   {
-    kDebug() << QString("found member '%1' [%2]").arg(m->members[id]->toPrintout()).arg(m->members[id]->id());
-    return m->members[id];
+    kDebug() << QString("found member '%1' [%2]").arg(m->album->members[id]->toPrintout()).arg(m->album->members[id]->id());
+    return m->album->members[id];
   }
   else
     throw Exception ( Error(ERR_DOES_NOT_EXIST), i18n("item with id '%1'").arg(id) );
@@ -397,7 +808,7 @@ QHash<g3index,G3Item*> G3Item::members ( )
   KDebug::Block block ( "G3Item::members" );
   kDebug() << "(<this>)" << toPrintout();
   buildMemberItems ( );
-  return m->members;
+  return m->album->members;
 } // G3Item::members
 
 /*!
@@ -406,7 +817,8 @@ QHash<g3index,G3Item*> G3Item::members ( )
  * @param  name name of the requested item
  * @return      wether the requested item does exist or not
  * Returns of the requested item does exist inside the parent item (album)
- * Note that the list of member items will be refreshed as required
+ * Note that the member will be retrieved as required, a missing member is
+ * not treated as an error.
  * @see G3Item
  * @author Christian Reiner
  */
@@ -414,22 +826,7 @@ bool G3Item::containsMember ( const QString& name )
 {
   KDebug::Block block ( "G3Item::containsMember" );
   kDebug() << "(<this> <name>)" << toPrintout() << name;
-  buildMemberItems ( );
-  try
-  {
-    member ( name );
-    return TRUE;
-  } // try
-  catch ( Exception e )
-  {
-    if ( ERR_DOES_NOT_EXIST==e.getCode() )
-    {
-      kDebug() << e.getText();
-      return FALSE;
-    }
-    else
-      throw e;
-  } // catch
+  return NULL!=findMember ( name );
 }
 
 /*!
@@ -447,7 +844,7 @@ bool G3Item::containsMember ( g3index id )
   KDebug::Block block ( "G3Item::containsMember" );
   kDebug() << "(<this> <id>)" << toPrintout() << id;
   buildMemberItems ( );
-  return m->members.contains ( id );
+  return m->album->members.contains ( id );
 }
 
 /*!
@@ -464,7 +861,7 @@ int G3Item::countMembers ( )
   KDebug::Block block ( "G3Item::countMembers" );
   kDebug() << "(<this>)" << toPrintout();
   buildMemberItems ( );
-  return m->members.count();
+  return m->album->members.count();
 } // G3Item::countMembers
 
 /*!
@@ -472,6 +869,8 @@ int G3Item::countMembers ( )
  * @brief Creates all member items as specified in the items description
  * Instanciates all member items contained inside a parent item (album).
  * Note that items already existing will not be re-created.
+ * Missing items are taken from the local cache if possible, all others are
+ * retrieved in chunks that are processed in parallel.
  * @see G3Item
  * @author Christian Reiner
  */
@@ -479,47 +878,295 @@ void G3Item::buildMemberItems ( )
 {
   KDebug::Block block ( "G3Item::buildMemberItems" );
   kDebug() << "(<this>)" << toPrintout();
-  QVariantList list = attributeList("members",TRUE).toList();
+  if ( ! m->hasMembers )
+    throw Exception ( Error(ERR_SLAVE_DEFINED),
+                      i18n("mandatory item attribute '%1' does not exist or does not have requested type").arg("members") );
   // members list oout of sync ?
-  if ( list.count()!=m->members.count() )
+  if ( m->album->memberIds.count()!=m->album->members.count() )
+    retrieveMembers ( mergeMembers(FALSE) );
+} // G3Item::getMembers
+
+/*!
+ * QVector<g3index> G3Item::mergeMembers ( bool publish )
+ * @brief Compares the members present with the members described
+ * @param  publish publish each member present that is still described
+ * @return         sorted ids of the members described but not present
+ * The sorted ids of the members described and of the members present are
+ * merged in a single linear pass. Members present but not described anymore
+ * ('stale members') are deleted on the way.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+QVector<g3index> G3Item::mergeMembers ( bool publish )
+{
+  kDebug() << "(<this> <publish>)" << toPrintout() << publish;
+  QVector<g3index> present;
+  present.reserve ( m->album->members.count() );
+  for ( QHash<g3index,G3Item*>::const_iterator it=m->album->members.constBegin(); it!=m->album->members.constEnd(); it++ )
+    present << it.key();
+  qSort ( present );
+  QVector<g3index> missing;
+  QVector<g3index>::const_iterator described = m->album->memberIds.constBegin ( );
+  QVector<g3index>::const_iterator existing  = present.constBegin ( );
+  while ( m->album->memberIds.constEnd()!=described || present.constEnd()!=existing )
   {
-    // note: we do NOT construct a list of KUrls, since we need to specify the urls as strings in the request url anyway
-    QHash<g3index,QString> urls;
-    foreach ( QVariant entry, list )
+    if ( present.constEnd()==existing || ( m->album->memberIds.constEnd()!=described && *described<*existing ) )
+      missing << *described++;
+    else if ( m->album->memberIds.constEnd()==described || *existing<*described )
     {
-      // entry is a "url string", the 'filename' is the items id
-      // e.g. http://gallery.some.server/rest/item/666
-      g3index id = QVariant(KUrl(entry.toString()).fileName()).toInt();
-      urls.insert ( id, entry.toString() );
-    } // foreach
-    // remove all 'stale members', members that are not mentioned in attribute 'members'
-    foreach ( G3Item* member, m->members )
-      if ( ! urls.contains(member->id()) )
+      // note: deleting a member removes it from both, the members list and the name index
+      G3Item* member = m->album->members.value ( *existing++ );
+      kDebug() << "removing stale member" << member->toPrintout();
+      delete member;
+    }
+    else
+    {
+      if ( publish )
+        publishMember ( m->album->members.value(*existing) );
+      described++;
+      existing++;
+    }
+  } // while
+  kDebug() << "{<missing[count]>}" << missing.count();
+  return missing;
+} // G3Item::mergeMembers
+
+/*!
+ * void G3Item::listMemberItems ( SlaveBase* slave )
+ * @brief Publishes all member items as UDS entries
+ * @param slave the slave the entries are listed by
+ * Publishes each member item as early as possible:
+ * members already present are published right away, members taken from the
+ * local cache before anything is requested and retrieved members chunk by
+ * chunk as soon as each chunk has been decoded.
+ * The entries are collected and handed over to the slave in batches, a batch
+ * is handed over when it is full, when its oldest
+ * entry exceeds the configured age and before waiting for the remote system.
+ * Albums holding more members than the configured page size are listed page
+ * by page: the member urls of each page are requested, the missing members of
+ * that page constructed, published and released again before the next page
+ * is requested. So only one page is held in memory at a time, released
+ * members are taken from the local cache when they are required later.
+ * Paging continues until a page comes back empty or as many members have
+ * been listed as the album describes. It also stops at a page that does not
+ * add any member not listed before, so a server ignoring the paging
+ * parameters cannot keep the loop going. Only a listing ended by an empty
+ * page is complete and replaces the albums list of members, removing members
+ * not listed anymore; otherwise members are only added.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::listMemberItems ( SlaveBase* slave )
+{
+  KDebug::Block block ( "G3Item::listMemberItems" );
+  kDebug() << "(<this>)" << toPrintout();
+  if ( ! m->hasMembers )
+    throw Exception ( Error(ERR_SLAVE_DEFINED),
+                      i18n("mandatory item attribute '%1' does not exist or does not have requested type").arg("members") );
+  const int page   = m->backend->settings().readEntry ( "ItemPageSize",      ITEM_LIST_PAGE_SIZE );
+  m->album->slave         = slave;
+  m->album->batchSize     = m->backend->settings().readEntry ( "ListBatchSize",     ITEM_LIST_BATCH_SIZE );
+  m->album->batchInterval = m->backend->settings().readEntry ( "ListBatchInterval", ITEM_LIST_BATCH_INTERVAL );
+  m->album->batch.clear ( );
+  try
+  {
+    if ( 0>=page || m->album->memberIds.count()<=page )
+      retrieveMembers ( mergeMembers(TRUE), TRUE );
+    else
+    {
+      const int        described = m->album->memberIds.count ( );
+      QVector<g3index> listed;
+      QSet<g3index>    seen;
+      bool             complete = FALSE;
+      // note: the server might cap the page size, so the next page starts after the urls received
+      for ( int start=0; ; )
       {
-        kDebug() << "removing stale member" << member->toPrintout();
-        m->members.remove ( member->id() );
-        delete member;
-      } // if
-      else
-        kDebug() << "keeping existing member" << member->toPrintout();
-    // identify all members not present but mentioned in attribute 'members'
-    foreach ( g3index id, urls.keys() )
-      if ( ! m->members.contains(id) )
-        // keep id in list of urls, will be used further down
-        kDebug() << "keeping id" << id << " in list of missing members";
-      else
+        flushMembers ( );
+        QStringList urls = G3Request::g3GetMemberUrls ( m->backend, m->id, QString(), start, page );
+        kDebug() << "page starting at" << start << "holds" << urls.count() << "members";
+        if ( urls.isEmpty() )
+        {
+          complete = TRUE;
+          break;
+        }
+        start += urls.count ( );
+        QVector<g3index> missing;
+        int              fresh = 0;
+        foreach ( const QString& url, urls )
+        {
+          g3index id = idFromUrl ( url );
+          if ( seen.contains(id) )
+            continue;
+          seen.insert ( id );
+          listed << id;
+          ++fresh;
+          if ( ! m->album->members.contains(id) )
+            missing << id;
+          else
+            publishMember ( m->album->members[id] );
+        } // foreach
+        retrieveMembers ( missing, TRUE );
+        flushMembers ( );
+        // members constructed only to be listed are released again, so only a page is held at a time
+        foreach ( g3index id, missing )
+          delete m->album->members.value ( id, NULL );
+        // a page without any new member means the server repeats itself
+        if ( 0==fresh || seen.count()>=described )
+          break;
+      } // for
+      if ( complete )
       {
-        kDebug() << "removing id" << id << "from list of missing members";
-        urls.remove ( id );
+        // all pages have been listed, they describe the current list of members
+        sortIds ( listed );
+        m->album->memberIds = listed;
+        m->album->missing.clear ( );
+        mergeMembers ( FALSE );
       }
-    // construct the required items
+      else
+        // the listing might be partial, members are only added, never removed
+        foreach ( g3index id, listed )
+          addMemberId ( id );
+    } // else
+  } // try
+  catch ( Exception e )
+  {
+    m->album->batch.clear ( );
+    m->album->slave = NULL;
+    throw e;
+  } // catch
+  flushMembers ( );
+  m->album->slave = NULL;
+} // G3Item::listMemberItems
+
+/*!
+ * void G3Item::publishMember ( const G3Item* member )
+ * @brief Adds the UDS entry of a member to the current batch
+ * @param member the member item to be published
+ * The batch is handed over when it is full or its oldest entry is too old.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::publishMember ( const G3Item* member )
+{
+  if ( m->album->batch.isEmpty() )
+  {
+    m->album->batch.reserve ( m->album->batchSize );
+    m->album->batchTime.start ( );
+  }
+  m->album->batch << member->toUDSEntry ( );
+  if ( m->album->batch.count()>=m->album->batchSize || m->album->batchTime.elapsed()>=m->album->batchInterval )
+    flushMembers ( );
+} // G3Item::publishMember
+
+/*!
+ * void G3Item::flushMembers ( )
+ * @brief Hands over the current batch of UDS entries
+ * Lists the entries via the slave if the batch holds any entries.
+ * The batch is cleared but keeps its capacity for the next entries.
+ * Called for each chunk of retrieved members, so does nothing unless the
+ * members of this album are currently listed.
+ * @see G3Request::getChunked
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::flushMembers ( )
+{
+  if ( NULL==m->album || m->album->batch.isEmpty() || NULL==m->album->slave )
+    return;
+  kDebug() << "handing over" << m->album->batch.count() << "entries";
+  m->album->slave->listEntries ( m->album->batch );
+  m->album->batch.erase ( m->album->batch.begin(), m->album->batch.end() );
+} // G3Item::flushMembers
+
+/*!
+ * void G3Item::retrieveMembers ( const QVector<g3index>& ids, bool publish )
+ * @brief Constructs member items not yet present
+ * @param ids     numeric ids of the missing members
+ * @param publish publish each member as soon as it has been constructed
+ * Members described in the local cache are taken from there, all others are
+ * retrieved in chunks that are processed in parallel. Ids of members present
+ * already are skipped. The cache service is asked once for all members
+ * missing, not for each of them. When publishing, the entries are handed over before
+ * the chunks are requested and again after each chunk has been constructed.
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::retrieveMembers ( const QVector<g3index>& ids, bool publish )
+{
+  KDebug::Block block ( "G3Item::retrieveMembers" );
+  kDebug() << "(<this> <ids[count]> <publish>)" << toPrintout() << ids.count() << publish;
+  // members are published by pushMember() as soon as they are constructed
+  m->album->listing = publish;
+  try
+  {
+    QVector<g3index> missing;
+    foreach ( g3index id, ids )
+      if ( ! m->album->members.contains(id) )
+        missing << id;
+    if ( m->backend->cache() )
+      m->backend->cache()->prefetch ( missing );
+    QStringList urls;
+    foreach ( g3index id, missing )
+    {
+      // members described in the local cache need not be retrieved
+      G3Item* member = m->backend->itemCached ( id, FALSE );
+      if ( NULL!=member )
+      {
+        if ( this==member->parent() )
+          continue;
+        // the cached record has been moved meanwhile
+        kDebug() << "ignoring outdated cache record of member" << member->toPrintout();
+        delete member;
+        m->backend->cache()->drop ( id );
+      } // if
+      urls << memberUrl ( id );
+    } // foreach
     if ( 0<urls.count() )
     {
       kDebug() << "constructing" << urls.count() << "missing member items";
-      QList<G3Item*> items = G3Request::g3GetItems ( m->backend, urls.values() );
+      // entries published so far need not wait for the remote system
+      if ( publish )
+        flushMembers ( );
+      G3Request::g3GetItems ( m->backend, urls );
     }
-  } // if
-} // G3Item::getMembers
+  } // try
+  catch ( Exception e )
+  {
+    m->album->listing = FALSE;
+    throw e;
+  } // catch
+  m->album->listing = FALSE;
+} // G3Item::retrieveMembers
+
+/*!
+ * const QString G3Item::memberUrl ( g3index id ) const
+ * @brief Synthesizes the rest url of a member
+ * @param  id numeric id of the member
+ * @return    rest url of the member, as used inside requests
+ * @see G3Item
+ * @author Christian Reiner
+ */
+const QString G3Item::memberUrl ( g3index id ) const
+{
+  return QString("%1/item/%2").arg(m->backend->restUrl().url(KUrl::RemoveTrailingSlash)).arg(id);
+} // G3Item::memberUrl
+
+/*!
+ * void G3Item::sortIds ( QVector<g3index>& ids )
+ * @brief Sorts a list of ids and removes duplicates
+ * @param ids list of numeric item ids, sorted in place
+ * @see G3Item
+ * @author Christian Reiner
+ */
+void G3Item::sortIds ( QVector<g3index>& ids )
+{
+  qSort ( ids );
+  int count = 0;
+  for ( int pos=0; pos<ids.size(); pos++ )
+    if ( 0==count || ids.at(pos)!=ids.at(count-1) )
+      ids[count++] = ids.at ( pos );
+  ids.resize ( count );
+} // G3Item::sortIds
 
 //==========
 
@@ -528,20 +1175,18 @@ void G3Item::buildMemberItems ( )
  * @brief Provides an items path
  * @return path in form of a list of breadcrumbs
  * Returns an items path inside the items hierarchy in form of a breadcrumb list. 
+ * The path is collected walking up the chain of parents, the base item
+ * itself is not part of the path.
  * @see G3Item
  * @author Christian Reiner
  */
 QStringList G3Item::path ( ) const
 {
-  KDebug::Block block ( "G3Item::path" );
   kDebug() << "(<this>)" << toPrintout();
-  if ( NULL!=m->parent )
-  {
-    QStringList path = m->parent->path();
-    path << name();
-    return path;
-  }
-  return QStringList();
+  QStringList path;
+  for ( const G3Item* item=this; NULL!=item->m->parent; item=item->m->parent )
+    path.prepend ( item->m->name );
+  return path;
 } // G3Item::path
 
 /*!
@@ -612,25 +1257,31 @@ const QString G3Item::toPrintout ( ) const
  * const UDSEntry G3Item::toUDSEntry ( ) const
  * @brief Publish item as UDS entry
  * @return UDSEntry describing the item object
- * Generates and returns a UDSEntry that describes the item object
+ * Returns a UDSEntry that describes the item object.
+ * The entry is built once and kept, it is only rebuilt when the items
+ * 'updated' value differs from the one the entry has been built for. Items
+ * changed on the remote system are refreshed in place, describe() drops the
+ * memoised entry then, so repeated stats and listings merely hand out a
+ * shared copy of an entry that is still valid.
  * @see G3Item
  * @author Christian Reiner
  */
 const UDSEntry G3Item::toUDSEntry ( ) const
 {
-  KDebug::Block block ( "G3Item::toUDSEntry" );
+  if ( 0!=m->entry.count() && m->entryUpdated==m->updated )
+    return m->entry;
   kDebug() << "(<this>)" << toPrintout();
   UDSEntry entry;
-  entry.insert( UDSEntry::UDS_NAME,               QString("%1").arg(m->name) );
+  entry.insert( UDSEntry::UDS_NAME,               m->name );
 //  entry.insert( UDSEntry::UDS_DISPLAY_NAME,       QString("[%1] %2").arg(m->id).arg(attributeMapToken("entity","title",QVariant::String).toString()) );
-  entry.insert( UDSEntry::UDS_COMMENT,            attributeMapToken("entity","description",QVariant::String).toString() );
+  entry.insert( UDSEntry::UDS_COMMENT,            m->description );
   entry.insert( UDSEntry::UDS_FILE_TYPE,          m->type.toUDSFileType() );
   entry.insert( UDSEntry::UDS_MIME_TYPE,          m->mimetype->name() );
   entry.insert( UDSEntry::UDS_DISPLAY_TYPE,       m->type.toString() );
-  entry.insert( UDSEntry::UDS_SIZE,               (G3Type::ALBUM==m->type.toInt()) ? 0L : attributeMapToken(QLatin1String("entity"),QLatin1String("file_size"),QVariant::Int).toInt() );
-  entry.insert( UDSEntry::UDS_ACCESS,             canEdit() ? 0600 : 0400 );
-  entry.insert( UDSEntry::UDS_CREATION_TIME,      attributeMapToken(QLatin1String("entity"),QLatin1String("created"),QVariant::Int).toInt() );
-  entry.insert( UDSEntry::UDS_MODIFICATION_TIME,  attributeMapToken(QLatin1String("entity"),QLatin1String("updated"),QVariant::Int).toInt() );
+  entry.insert( UDSEntry::UDS_SIZE,               m->size );
+  entry.insert( UDSEntry::UDS_ACCESS,             m->canEdit ? 0600 : 0400 );
+  entry.insert( UDSEntry::UDS_CREATION_TIME,      m->created );
+  entry.insert( UDSEntry::UDS_MODIFICATION_TIME,  m->updated );
 //  entry.insert( UDSEntry::UDS_LOCAL_PATH,         m_fileUrl.path() );
 //  entry.insert( UDSEntry::UDS_URL,                m_fileUrl.url() );
 //  entry.insert( UDSEntry::UDS_TARGET_URL,         m_fileUrl.url() );
@@ -640,59 +1291,31 @@ const UDSEntry G3Item::toUDSEntry ( ) const
   entry.insert( UDSEntry::UDS_USER,               user.loginName() );
   entry.insert( UDSEntry::UDS_GROUP,              user.groupNames().first() );
 */
-
-  // some intense debugging output...
-  QList<uint> _tags = entry.listFields ( );
-  kDebug() << "list of defined UDS entry tags for entry" << toPrintout() << QLatin1String(":");
-  foreach ( uint _tag, _tags )
-    switch ( _tag )
-    {
-      case UDSEntry::UDS_NAME:               kDebug() << "UDS_NAME:"               << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_DISPLAY_NAME:       kDebug() << "UDS_DISPLAY_NAME:"       << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_COMMENT:            kDebug() << "UDS_COMMENT:"            << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_FILE_TYPE:          kDebug() << "UDS_FILE_TYPE:"          << entry.numberValue(_tag); break;
-      case UDSEntry::UDS_MIME_TYPE:          kDebug() << "UDS_MIME_TYPE:"          << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_MODIFICATION_TIME:  kDebug() << "UDS_MODIFICATION_TIME:"  << entry.numberValue(_tag); break;
-      case UDSEntry::UDS_CREATION_TIME:      kDebug() << "UDS_CREATION_TIME:"      << entry.numberValue(_tag); break;
-      case UDSEntry::UDS_DISPLAY_TYPE:       kDebug() << "UDS_DISPLAY_TYPE:"       << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_LOCAL_PATH:         kDebug() << "UDS_LOCAL_PATH:"         << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_URL:                kDebug() << "UDS_URL:"                << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_TARGET_URL:         kDebug() << "UDS_TARGET_URL:"         << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_LINK_DEST:          kDebug() << "UDS_LINK_DEST:"          << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_SIZE:               kDebug() << "UDS_SIZE:"               << entry.numberValue(_tag); break;
-      case UDSEntry::UDS_GUESSED_MIME_TYPE:  kDebug() << "UDS_GUESSED_MIME_TYPE:"  << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_ACCESS:             kDebug() << "UDS_ACCESS:"             << entry.numberValue(_tag); break;
-      case UDSEntry::UDS_ICON_NAME:          kDebug() << "UDS_ICON_NAME:"          << entry.stringValue(_tag); break;
-      case UDSEntry::UDS_ICON_OVERLAY_NAMES: kDebug() << "UDS_ICON_OVERLAY_NAMES:" << entry.stringValue(_tag); break;
-      default:                               kDebug() << "UDS_<UNKNOWN>:"          << _tag;
-    } // switch
+  m->entry        = entry;
+  m->entryUpdated = m->updated;
   return entry;
 } // G3Item::toUDSEntry
 
 /*!
- * const UDSEntryList G3Item::toUDSEntryList ( bool signalEntries ) const
+ * const UDSEntryList G3Item::toUDSEntryList ( ) const
  * @brief Publish items members as UDS entries
- * @param signalEntries output entries via signal or collected at the end
+ * @return list of UDS entries of all member items present
  * Generates a list of UDSEntries of all member items contained.
- * The flag 'signalEntries' results in single UDSentries being emitted via the
- * signal 'signalUDSEntry'. If not set all entries will be returned in form of
- * a UDSEntrylist at the end of the method. 
  * @see G3Item
  * @author Christian Reiner
  */
-const UDSEntryList G3Item::toUDSEntryList ( bool signalEntries ) const
+const UDSEntryList G3Item::toUDSEntryList ( ) const
 {
   KDebug::Block block ( "G3Item::toUDSEntryList" );
   kDebug() << "(<this>)" << toPrintout();
   // NOTE: the CALLING func has to make sure the members array is complete and up2date
   // generate and return final list
   UDSEntryList list;
-  kDebug() << "listing" << m->members.count() << "item members";
-  foreach ( G3Item* member, m->members )
-    if ( signalEntries )
-      emit signalUDSEntry ( member->toUDSEntry() );
-    else
-      list << member->toUDSEntry();
+  if ( NULL==m->album )
+    return list;
+  kDebug() << "listing" << m->album->members.count() << "item members";
+  foreach ( G3Item* member, m->album->members )
+    list << member->toUDSEntry();
   kDebug() << "{<UDSEntryList[count]>}" << list.count();
   return list;
 } // G3Item::toUDSEntryList
@@ -799,5 +1422,3 @@ G3CommentItem::G3CommentItem ( G3Backend* const backend, const QVariantMap& attr
   KDebug::Block block ( "G3CommentItem::G3CommentItem" );
   kDebug() << "(<backend> <attributes>)" << backend->toPrintout() << QStringList(attributes.keys()).join(QLatin1String(","));
 } // G3CommentItem::G3CommentItem
-
-#include "entity/g3_item.moc"
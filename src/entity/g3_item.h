@@ -19,11 +19,16 @@
 #define ENTITY_G3_ITEM_H
 
 #include <QVariant>
+#include <QSet>
+#include <QVector>
+#include <QTime>
 #include <kio/global.h>
 #include <kio/udsentry.h>
+#include <kio/slavebase.h>
 #include <kmimetype.h>
 #include <kdatetime.h>
 #include "utility/defines.h"
+#include "utility/pool.h"
 #include "entity/g3_type.h"
 
 namespace KIO
@@ -40,6 +45,10 @@ namespace KIO
     * - all private members are published via direct access methods (read only)
     * - in addition a number of convenience constructions are offered as methods as well
     *   these are generated based only on the constant settings stored in the members mentioned above
+    * - the frequently used tokens of the description are decoded once into typed members,
+    *   the complete description is kept serialized and only decoded when a rare attribute is requested
+    * - items are plain objects without signals, the private members are taken from a pool and
+    *   the containers required to hold members are only allocated for albums
     * 
     * @see G3AlbumItem
     * @see G3PhotoItemG3MovieItem
@@ -47,50 +56,121 @@ namespace KIO
     * @see G3CommentItem
     */
     class G3Item
-      : public QObject
     {
+      public:
+        enum Url { REST, COVER, WEB, WEB_PUBLIC, FILE, FILE_PUBLIC, RESIZE, RESIZE_PUBLIC, THUMB, THUMB_PUBLIC, URL_COUNT };
+      private:
+      // everything only an item holding members (album) requires
+      class Album
+      {
+        public:
+        inline Album ( ) : slave(NULL), listing(FALSE), batchSize(ITEM_LIST_BATCH_SIZE), batchInterval(ITEM_LIST_BATCH_INTERVAL) { }
+        QVector<g3index>       memberIds;  // ids of the members as listed in the description, sorted
+        QHash<g3index,G3Item*> members;
+        QHash<QString,G3Item*> names;      // index of the members by name, kept in sync with 'members'
+        QSet<QString>          missing;    // names known not to exist, as long as the list of members is unchanged
+        SlaveBase*             slave;      // slave the members are listed to
+        bool                   listing;    // members pushed are published right away
+        UDSEntryList           batch;      // entries published but not yet handed over
+        int                    batchSize;
+        int                    batchInterval;
+        QTime                  batchTime;  // age of the oldest entry in the batch
+      }; // class Album
       class Members
       {
         public:
-        inline Members ( const G3Type type, G3Backend* const backend, const QVariantMap& attributes) : type(type), backend(backend), attributes(attributes) { }
+        inline Members ( const G3Type type, G3Backend* const backend ) : type(type), backend(backend), id(0), parentId(0), parent(NULL), size(0), created(0), updated(0), canEdit(FALSE), hasMembers(FALSE), album(NULL), entryUpdated(0), touched(0), footprint(0), fetched(0) { }
+        inline ~Members ( ) { delete album; }
         const G3Type           type;
         G3Backend* const       backend;
         g3index                id;
+        g3index                parentId;
         QString                name;
         KMimeType::Ptr         mimetype;
         G3Item*                parent;
-        QHash<g3index,G3Item*> members;
-        QVariantMap            attributes;
+        qint64                 size;
+        uint                   created;
+        uint                   updated;
+        bool                   canEdit;
+        bool                   hasMembers;
+        QString                description;
+        QString                urls[URL_COUNT]; // plain urls or interned templates the id is inserted into
+        qint16                 idAt[URL_COUNT]; // position the id is inserted at, -1 for plain urls
+        Album*                 album;      // members of an album, NULL for items without members
+        QByteArray             blob;       // complete description, only decoded when a rarely used attribute is requested
+        UDSEntry               entry;      // memoised description published to the calling scope
+        uint                   entryUpdated; // value of 'updated' the memoised entry was built for
+        uint                   touched;    // stamp of the last command the item was used by
+        int                    footprint;  // rough estimate of the memory held, in bytes
+        uint                   fetched;    // time the description was retrieved from the remote system
       }; // class Members
-      Q_OBJECT
+      // the private members of the items of a backend are taken from the pool of that backend
+      friend class G3ItemPool;
       private:
         Members* const m;
+        const KUrl     url        ( Url which, bool strict ) const;
+        const QString  urlString  ( Url which ) const;
+        void           setUrl     ( Url which, const QString& url );
+        QVariantMap    attributes ( ) const;
+        Album*           album           ( );
+        void             describe        ( const QVariantMap& attributes );
+        const QString    memberUrl       ( g3index id ) const;
+        QVector<g3index> mergeMembers    ( bool publish );
+        void             retrieveMembers ( const QVector<g3index>& ids, bool publish=FALSE );
+        void             publishMember   ( const G3Item* member );
+        static void      sortIds         ( QVector<g3index>& ids );
       protected:
         G3Item ( const G3Type type, G3Backend* const backend, const QVariantMap& data );
       public:
         static G3Item* const instantiate ( G3Backend* const backend, const QVariantMap& data );
-        ~G3Item ( );
-      signals:
-        void signalUDSEntry ( const UDSEntry& entry ) const;
+        /*!
+         * @brief Extracts the numeric id from an items rest url
+         * The id is the trailing path component of the url, e.g. 'http://gallery.some.server/rest/item/666'.
+         * It is parsed in place, no KUrl or intermediate string is constructed.
+         */
+        static inline g3index idFromUrl ( const QString& url )
+        {
+          int pos = url.size ( );
+          while ( 0<pos && url.at(pos-1).isDigit() )
+            pos--;
+          g3index id = 0;
+          for ( ; pos<url.size(); pos++ )
+            id = 10*id + url.at(pos).digitValue();
+          return id;
+        }
+        virtual ~G3Item ( );
       public:
         inline const G3Type         type     ( ) const { return m->type; }
         inline const g3index        id       ( ) const { return m->id; }
         inline const QString        name     ( ) const { return m->name; }
         inline const KMimeType::Ptr mimetype ( ) const { return m->mimetype; }
-        inline int                  size            ( bool strict=FALSE ) const { return (G3Type::ALBUM==m->type.toInt()) ? 0L : attributeMapToken(QLatin1String("entity"),QLatin1String("file_size"),QVariant::Int).toInt(); }
-        inline bool                 canEdit         ( bool strict=FALSE ) const { return attributeMapToken ( QLatin1String("entity"), QLatin1String("can_edit"), QVariant::Bool, strict ).toBool(); }
-        inline const KUrl           restUrl         ( bool strict=FALSE ) const { return KUrl ( attributeToken    (                          QLatin1String("url"),               QVariant::String, strict ).toString() ); }
-        inline const KUrl           coverUrl        ( bool strict=FALSE ) const { return KUrl ( attributeMapToken ( QLatin1String("entity"), QLatin1String("album_cover"),       QVariant::String, strict ).toString() ); }
-        inline const KUrl           webUrl          ( bool strict=FALSE ) const { return KUrl ( attributeMapToken ( QLatin1String("entity"), QLatin1String("web_url"),           QVariant::String, strict ).toString() ); }
-        inline const KUrl           webUrlPublic    ( bool strict=FALSE ) const { return KUrl ( attributeMapToken ( QLatin1String("entity"), QLatin1String("web_url_public"),    QVariant::String, strict ).toString() ); }
-        inline const KUrl           fileUrl         ( bool strict=FALSE ) const { return KUrl ( attributeMapToken ( QLatin1String("entity"), QLatin1String("file_url"),          QVariant::String, strict ).toString() ); }
-        inline const KUrl           fileUrlPublic   ( bool strict=FALSE ) const { return KUrl ( attributeMapToken ( QLatin1String("entity"), QLatin1String("file_url_public"),   QVariant::String, strict ).toString() ); }
-        inline const KUrl           resizeUrl       ( bool strict=FALSE ) const { return KUrl ( attributeMapToken ( QLatin1String("entity"), QLatin1String("resize_url"),        QVariant::String, strict ).toString() ); }
-        inline const KUrl           resizeUrlPublic ( bool strict=FALSE ) const { return KUrl ( attributeMapToken ( QLatin1String("entity"), QLatin1String("resize_url_public"), QVariant::String, strict ).toString() ); }
-        inline const KUrl           thumbUrl        ( bool strict=FALSE ) const { return KUrl ( attributeMapToken ( QLatin1String("entity"), QLatin1String("thumb_url"),         QVariant::String, strict ).toString() ); }
-        inline const KUrl           thumbUrlPublic  ( bool strict=FALSE ) const { return KUrl ( attributeMapToken ( QLatin1String("entity"), QLatin1String("thumb_url_public"),  QVariant::String, strict ).toString() ); }
+        inline qint64               size            ( bool strict=FALSE ) const { Q_UNUSED(strict); return m->size; }
+        inline bool                 canEdit         ( bool strict=FALSE ) const { Q_UNUSED(strict); return m->canEdit; }
+        inline uint                 created         ( ) const { return m->created; }
+        inline uint                 updated         ( ) const { return m->updated; }
+        inline g3index              parentId        ( ) const { return m->parentId; }
+        inline int                  countMemberIds  ( ) const { return m->album ? m->album->memberIds.count() : 0; }
+        inline int                  countMembersPresent ( ) const { return m->album ? m->album->members.count() : 0; }
+        inline uint                 touched         ( ) const { return m->touched; }
+        inline void                 touch           ( uint stamp ) { m->touched = stamp; }
+        inline int                  footprint       ( ) const { return m->footprint; }
+        inline uint                 fetched         ( ) const { return m->fetched; }
+        inline void                 setFetched      ( uint fetched ) { m->fetched = fetched; }
+        inline QList<G3Item*>       membersPresent  ( ) const { return m->album ? m->album->members.values() : QList<G3Item*>(); }
+        inline const KUrl           restUrl         ( bool strict=FALSE ) const { return url ( REST,          strict ); }
+        inline const KUrl           coverUrl        ( bool strict=FALSE ) const { return url ( COVER,         strict ); }
+        inline const KUrl           webUrl          ( bool strict=FALSE ) const { return url ( WEB,           strict ); }
+        inline const KUrl           webUrlPublic    ( bool strict=FALSE ) const { return url ( WEB_PUBLIC,    strict ); }
+        inline const KUrl           fileUrl         ( bool strict=FALSE ) const { return url ( FILE,          strict ); }
+        inline const KUrl           fileUrlPublic   ( bool strict=FALSE ) const { return url ( FILE_PUBLIC,   strict ); }
+        inline const KUrl           resizeUrl       ( bool strict=FALSE ) const { return url ( RESIZE,        strict ); }
+        inline const KUrl           resizeUrlPublic ( bool strict=FALSE ) const { return url ( RESIZE_PUBLIC, strict ); }
+        inline const KUrl           thumbUrl        ( bool strict=FALSE ) const { return url ( THUMB,         strict ); }
+        inline const KUrl           thumbUrlPublic  ( bool strict=FALSE ) const { return url ( THUMB_PUBLIC,  strict ); }
         QStringList            path              ( ) const;
         G3Item*                parent            ( ) const;
+        G3Item*                findMember        ( const QString& name );
+        void                   flushMembers      ( );
         G3Item*                member            ( const QString& name );
         G3Item*                member            ( g3index id );
         QHash<g3index,G3Item*> members           ( );
@@ -98,9 +178,15 @@ namespace KIO
         bool                   containsMember    ( g3index id );
         int                    countMembers      ( );
         void                   buildMemberItems  ( );
+        void                   listMemberItems   ( SlaveBase* slave );
         void                   pushMember        ( G3Item* member );
         G3Item*                popMember         ( G3Item* member );
         G3Item*                popMember         ( g3index id );
+        void                   evictMembers      ( );
+        bool                   matches           ( const QVariantMap& attributes ) const;
+        void                   refresh           ( const QVariantMap& attributes );
+        void                   addMemberId       ( g3index id );
+        void                   removeMemberId    ( g3index id );
         void                   setParent         ( G3Item* parent );
         const QVariant         attributeToken    ( const QString& attribute, QVariant::Type type, bool strict=FALSE ) const;
         const QVariant         attributeMap      ( const QString& attribute, bool strict=FALSE ) const;
@@ -111,12 +197,25 @@ namespace KIO
         const G3Item& operator<< ( G3Item& member );
         const QString                toPrintout     ( ) const;
         const UDSEntry               toUDSEntry     ( ) const;
-        const UDSEntryList           toUDSEntryList ( bool signalEntries=FALSE ) const;
+        const UDSEntryList           toUDSEntryList ( ) const;
         const QHash<QString,QString> toAttributes   ( ) const;
   //      QByteArray toJSON ( ) const;
   //      G3Item&    fromJSON ( const QByteArray& json );
     }; // class G3Item
 
+    /*!
+     * @class G3ItemPool
+     * @brief Pool the private members of the items of a backend are taken from
+     * Each backend owns its pool and destroys it after all its items have been
+     * deleted, so the memory is returned when the backend is released.
+     * @see G3Backend
+     * @see Pool
+     */
+    class G3ItemPool
+      : public Pool<G3Item::Members>
+    {
+    }; // class G3ItemPool
+
 //==========
 
     /*!
@@ -20,7 +20,7 @@
 #define ENTITY_G3_TYPE_H
 
 #include <sys/stat.h>
-#include <QHash>
+#include <QString>
 #include <QDataStream>
 #include <QFile>
 #include <KMimeType>
@@ -38,69 +38,100 @@ namespace KIO
      * Implements an "intelligent type definition" that connects both worlds understanding of a 'type':
      * - c++ style type in form of an enumeration and projection on an integer to be used in switch statements
      * - gallery3 style type in form of strings describing the meaning, content and usage of an item
+     * The object itself holds nothing but the numeric value, so it can be copied
+     * freely. All conversions use static tables that are set up only once:
+     * names and file types are indexed by the numeric value, mimetypes are
+     * kept in a sorted table and looked up by a binary search.
      * This is a header-only implementation, no source or object file has to be be considered.
      * @author Christian Reiner
      */
     class G3Type
     {
+      public:
+        enum { NONE, ALBUM, MOVIE, PHOTO, TAG, COMMENT };
       private:
-        QHash<int,QString> m_name_map;
-        QHash<int,int>     m_node_map;
-        QHash<QString,int> m_mime_map;
+        struct Mime { const char* name; int value; };
+        // names, indexed by the numeric value
+        static inline const QString* names ( )
+        {
+          static const QString table[] = { QString(),              QLatin1String("album"), QLatin1String("movie"),
+                                           QLatin1String("photo"), QLatin1String("tag"),   QLatin1String("comment") };
+          return table;
+        }
+        // uds file types, indexed by the numeric value
+        static inline const int* nodes ( )
+        {
+          static const int table[] = { 0, S_IFDIR, S_IFREG, S_IFREG, S_IFREG, S_IFREG };
+          return table;
+        }
+        // mimetypes, sorted by name for a binary search
+        static inline const Mime* mimes ( int& count )
+        {
+          static const Mime table[] = { { "image/bmp",          G3Type::PHOTO },
+                                        { "image/gif",          G3Type::PHOTO },
+                                        { "image/jpeg",         G3Type::PHOTO },
+                                        { "image/png",          G3Type::PHOTO },
+                                        { "image/tiff",         G3Type::PHOTO },
+                                        { "inode/directory",    G3Type::ALBUM },
+                                        { "video/avi",          G3Type::MOVIE },
+                                        { "video/divx",         G3Type::MOVIE },
+                                        { "video/mp4",          G3Type::MOVIE },
+                                        { "video/mpeg",         G3Type::MOVIE },
+                                        { "video/ogg",          G3Type::MOVIE },
+                                        { "video/webm",         G3Type::MOVIE },
+                                        { "video/x-ms-asf",     G3Type::MOVIE },
+                                        { "video/x-ms-video",   G3Type::MOVIE },
+                                        { "video/x-ms-wmv",     G3Type::MOVIE },
+                                        { "video/x-theora+ogg", G3Type::MOVIE } };
+          count = sizeof(table) / sizeof(Mime);
+          return table;
+        }
+        static inline bool valid ( int value ) { return NONE<=value && COMMENT>=value; }
+        static inline int fromName ( const QString& name )
+        {
+          for ( int value=ALBUM; value<=COMMENT; value++ )
+            if ( name==names()[value] )
+              return value;
+          return NONE;
+        }
+        static inline int fromMime ( const QString& name )
+        {
+          int count;
+          const Mime* table = mimes ( count );
+          int lower=0, upper=count-1;
+          while ( lower<=upper )
+          {
+            int pos   = (lower+upper) / 2;
+            int order = name.compare ( QLatin1String(table[pos].name), Qt::CaseInsensitive );
+            if ( 0==order )
+              return table[pos].value;
+            if ( 0>order )
+              upper = pos-1;
+            else
+              lower = pos+1;
+          } // while
+          return NONE;
+        }
       protected:
         int                m_value;
       public:
-        enum { NONE, ALBUM, MOVIE, PHOTO, TAG, COMMENT };
-        inline G3Type ( int value )                  { setup(); m_value = value; }
-        inline G3Type ( const char* name )           { setup(); m_value = m_name_map.key(name); }
-        inline G3Type ( const QString& name )        { setup(); m_value = m_name_map.key(name); }
-        inline G3Type ( const KMimeType::Ptr& mime ) { setup(); m_value = m_mime_map.value(mime->name().toLower()); }
-        inline G3Type ( )                     { setup(); }
-        inline void setup ( )
-        {
-          m_name_map.insert ( G3Type::NONE,    QLatin1String("") );
-          m_name_map.insert ( G3Type::ALBUM,   QLatin1String("album") );
-          m_name_map.insert ( G3Type::MOVIE,   QLatin1String("movie") );
-          m_name_map.insert ( G3Type::PHOTO,   QLatin1String("photo") );
-          m_name_map.insert ( G3Type::TAG,     QLatin1String("tag")) ;
-          m_name_map.insert ( G3Type::COMMENT, QLatin1String("comment")) ;
-          m_node_map.insert ( G3Type::NONE,    0 );
-          m_node_map.insert ( G3Type::ALBUM,   S_IFDIR );
-          m_node_map.insert ( G3Type::MOVIE,   S_IFREG );
-          m_node_map.insert ( G3Type::PHOTO,   S_IFREG );
-          m_node_map.insert ( G3Type::TAG,     S_IFREG );
-          m_node_map.insert ( G3Type::COMMENT, S_IFREG );
-          m_mime_map.insert ( QLatin1String("inode/directory"),    G3Type::ALBUM );
-          m_mime_map.insert ( QLatin1String("image/jpeg"),         G3Type::PHOTO );
-          m_mime_map.insert ( QLatin1String("image/tiff"),         G3Type::PHOTO );
-          m_mime_map.insert ( QLatin1String("image/bmp"),          G3Type::PHOTO );
-          m_mime_map.insert ( QLatin1String("image/gif"),          G3Type::PHOTO );
-          m_mime_map.insert ( QLatin1String("image/png"),          G3Type::PHOTO );
-          m_mime_map.insert ( QLatin1String("video/avi"),          G3Type::MOVIE );
-          m_mime_map.insert ( QLatin1String("video/divx"),         G3Type::MOVIE );
-          m_mime_map.insert ( QLatin1String("video/mpeg"),         G3Type::MOVIE );
-          m_mime_map.insert ( QLatin1String("video/mp4"),          G3Type::MOVIE );
-          m_mime_map.insert ( QLatin1String("video/ogg"),          G3Type::MOVIE );
-          m_mime_map.insert ( QLatin1String("video/webm"),         G3Type::MOVIE );
-          m_mime_map.insert ( QLatin1String("video/x-ms-asf"),     G3Type::MOVIE );
-          m_mime_map.insert ( QLatin1String("video/x-ms-wmv"),     G3Type::MOVIE );
-          m_mime_map.insert ( QLatin1String("video/x-ms-video"),   G3Type::MOVIE );
-          m_mime_map.insert ( QLatin1String("video/x-theora+ogg"), G3Type::MOVIE );
-        }; // constructor
-        inline int           operator[]    ( const char* value )   const { return m_name_map.key(value); }
-        inline const QString operator[]    ( int         key   )   const { return m_name_map.value(key); }
-        inline int           toInt         ( )                     const { return m_value; }
-        inline const QString toString      ( )                     const { return m_name_map[m_value]; }
-        inline int           toUDSFileType ( )                     const { return m_node_map[m_value]; }
-        inline bool          operator==    ( const G3Type& other ) const { return m_value==other.m_value; }
-        inline bool          operator==    (       G3Type& other ) const { return m_value==other.m_value; }
-        inline bool          operator!=    ( const G3Type& other ) const { return m_value!=other.m_value; }
-        inline bool          operator!=    (       G3Type& other ) const { return m_value!=other.m_value; }
-        inline int           operator=     ( int value )                 { m_value=value;  return value; }
-        inline int           operator=     ( const QString& name)        { m_value=m_name_map.key(name); return m_value; }
+        inline G3Type ( int value )                  : m_value ( value ) { }
+        inline G3Type ( const char* name )           : m_value ( fromName(QLatin1String(name)) ) { }
+        inline G3Type ( const QString& name )        : m_value ( fromName(name) ) { }
+        inline G3Type ( const KMimeType::Ptr& mime ) : m_value ( fromMime(mime->name()) ) { }
+        inline G3Type ( )                            : m_value ( NONE ) { }
+        inline int            operator[]    ( const char* value )   const { return fromName(QLatin1String(value)); }
+        inline const QString& operator[]    ( int         key   )   const { return names()[valid(key)?key:NONE]; }
+        inline int            toInt         ( )                     const { return m_value; }
+        inline const QString& toString      ( )                     const { return names()[valid(m_value)?m_value:NONE]; }
+        inline int            toUDSFileType ( )                     const { return nodes()[valid(m_value)?m_value:NONE]; }
+        inline bool           operator==    ( const G3Type& other ) const { return m_value==other.m_value; }
+        inline bool           operator!=    ( const G3Type& other ) const { return m_value!=other.m_value; }
+        inline int            operator=     ( int value )                 { m_value=value;  return value; }
+        inline int            operator=     ( const QString& name)        { m_value=fromName(name); return m_value; }
     }; // class G3Type
 
-    QDataStream & operator<< ( QDataStream & stream, const G3Type & type );
+    inline QDataStream & operator<< ( QDataStream & stream, const G3Type & type ) { return stream << type.toString(); }
 
   } // namespeace Gallery3
 } // namespace KIO
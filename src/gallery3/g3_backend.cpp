@@ -12,9 +12,17 @@
  * @see G3Backend
  * @author Christian Reiner
  */
+#include <QPair>
+#include <QVector>
+#include <QtAlgorithms>
+#include <QDateTime>
 #include <klocalizedstring.h>
+#include <kglobal.h>
+#include <ksharedconfig.h>
 #include "utility/exception.h"
 #include "gallery3/g3_backend.h"
+#include "gallery3/g3_cache.h"
+#include "gallery3/g3_pipeline.h"
 #include "gallery3/g3_request.h"
 #include "entity/g3_file.h"
 #include "entity/g3_item.h"
@@ -30,6 +38,10 @@ using namespace KIO::Gallery3;
  * Detects and returns the position (url) of the G3-API based on any given
  * Strategy: the REST API must be some base folder of the requested url
  *           so we test each breadcrump one by one (shortening the url) until we find the service
+ * Existing backends are found the same way: the url is shortened breadcrumb by
+ * breadcrumb and each prefix is looked up directly in the dictionary of
+ * backends, which is keyed by their base urls. So the effort depends on the
+ * depth of the requested url, not on the number of backends.
  * Note: this appears horrible, but there are two reasons for this:
  * 1.) our slave might be re-used to access more than one single gallery
  * 2.) there might be more than one gallery sharing the same start url
@@ -42,16 +54,23 @@ G3Backend* const G3Backend::instantiate ( QObject* parent, QHash<QString,G3Backe
   kDebug() << "(<url>)" << g3Url;
   G3Backend* backend;
   // try if any existing backend is assiciated with a sub-URL of the requested one
-  QHash<QString,G3Backend*>::const_iterator it;
-  for ( it=backends.constBegin(); it!=backends.constEnd(); it++ )
+  if ( ! backends.isEmpty() )
   {
-    backend = it.value();
-    if ( backend->baseUrl().isParentOf(g3Url) )
+    KUrl prefix = g3Url;
+    forever
     {
-      kDebug() << QString("detected existing G3-API url '%1', reusing associated backend").arg(backend->restUrl().prettyUrl());
-      return backend;
-    } // if
-  }
+      backend = backends.value ( prefix.url(), NULL );
+      if ( NULL!=backend )
+      {
+        kDebug() << QString("detected existing G3-API url '%1', reusing associated backend").arg(backend->restUrl().prettyUrl());
+        return backend;
+      } // if
+      const QString directory = prefix.directory ( );
+      if ( prefix.path().isEmpty() || directory==prefix.path() )
+        break;
+      prefix.setPath ( directory );
+    } // forever
+  } // if
   // try all sub-urls downwards in an iterative manner until we either find an existing API or we have to give up
   do
   {
@@ -85,6 +104,7 @@ G3Backend::G3Backend ( QObject* parent, const KUrl& g3Url )
   , m       ( new G3Backend::Members(g3Url) )
 {
   KDebug::Block block ( "G3Backend::G3Backend" );
+  m->pool    = new G3ItemPool;
   m->restUrl = m->baseUrl;
   m->restUrl.setProtocol ( (QLatin1String("gallery3s")==m->baseUrl.protocol()) ? QLatin1String("https"):QLatin1String("http") );
   // authentication credentials dont make sense since the REST API does not use http basic authentication
@@ -107,13 +127,39 @@ G3Backend::G3Backend ( QObject* parent, const KUrl& g3Url )
     m->credentials.username = m->baseUrl.userName();
     m->credentials.readOnly = TRUE;
   }
-}
+  // requests against this gallery are processed in parallel by a pipeline
+  KConfigGroup config = settings ( );
+  m->pipeline = new G3Pipeline ( this, config.readEntry("RequestConcurrency",REQUEST_CONCURRENCY) );
+  // items are retrieved in chunks, the chunk size might adapt to the servers limits
+  m->chunking = G3Chunking ( config.readEntry ( "ItemChunkSize",         ITEM_LIST_CHUNK_SIZE ),
+                             config.readEntry ( "ItemChunkSizeMax",      ITEM_LIST_CHUNK_SIZE_MAX ),
+                             config.readEntry ( "ItemChunkAdaptive",     FALSE ),
+                             config.readEntry ( "ItemChunkResponseTime", ITEM_LIST_RESPONSE_TIME ),
+                             config.readEntry ( "ItemChunkUrlLength",    ITEM_LIST_URL_LENGTH ),
+                             G3Chunking::methodFromString(config.readEntry("ItemChunkMethod",QString("auto"))) );
+  kDebug() << "chunk size" << m->chunking.size() << (m->chunking.isAdaptive()?"(adaptive)":"(fixed)");
+  // the items kept in memory are limited by a budget, configured in kilobytes
+  m->budget = 1024 * qint64 ( config.readEntry("ItemMemoryBudget",ITEM_MEMORY_BUDGET) );
+  // items kept in memory are revalidated when they have passed the time to live of their type
+  m->ttl[G3Type::NONE]    = ITEM_TTL_FILE;
+  m->ttl[G3Type::ALBUM]   = config.readEntry ( "ItemTTLAlbum", ITEM_TTL_ALBUM );
+  m->ttl[G3Type::MOVIE]   = config.readEntry ( "ItemTTLMovie", ITEM_TTL_FILE );
+  m->ttl[G3Type::PHOTO]   = config.readEntry ( "ItemTTLPhoto", ITEM_TTL_FILE );
+  m->ttl[G3Type::TAG]     = ITEM_TTL_FILE;
+  m->ttl[G3Type::COMMENT] = ITEM_TTL_FILE;
+  // item descriptions are kept on disk to speed up later sessions and shared with concurrent slaves
+  if ( config.readEntry("ItemCache",TRUE) )
+    m->cache = new G3Cache ( m->baseUrl, m->credentials.username,
+                             config.readEntry("ItemCacheTTL",ITEM_CACHE_TTL),
+                             config.readEntry("ItemCacheService",TRUE) );
+} // G3Backend::G3Backend
 
 /*!
  * G3Backend::~G3Backend ( )
  * @brief Desctructor
  * Recursively deletes all registered items associated to this backend by
- * deleting the base item
+ * deleting the base item, afterwards the pool the items were taken from is
+ * released.
  * @see G3Backend
  * @author Christian Reiner
  */
@@ -121,22 +167,24 @@ G3Backend::~G3Backend ( )
 {
   KDebug::Block block ( "G3Backend::~G3Backend" );
   kDebug() << "(<>)";
+  // write pending item descriptions to disk
+  delete m->cache;
   // remove all items generated on-the-fly if the base item exists at all
   kDebug() << "deleting base item";
   if ( m->items.contains(1) )
-  {
     delete itemBase ( );
-    m->items.remove ( 1 );
-  }
   // remove any orphaned items
   kDebug() << "removing " << m->items.count() << "orphaned items";
   while ( ! m->items.isEmpty() )
   {
-    QHash<g3index,G3Item*>::const_iterator item = m->items.constBegin();
-    kDebug() << "deleting item" << item.value()->toPrintout();
-    delete item.value();
+    G3Item* item = m->items.any ( );
+    kDebug() << "deleting item" << item->toPrintout();
+    delete item;
   } // while
   kDebug() << m->items.count() << "items left after removal of orphans";
+  // all items are gone, so their pool can be released
+  kDebug() << "releasing item pool of" << m->pool->size() << "bytes";
+  delete m->pool;
   // delete private members
   delete m;
 }
@@ -186,6 +234,64 @@ const QString G3Backend::toPrintout ( ) const
   return QString("G3Backend [%1 items] (%2)").arg(m->items.count()).arg(m->baseUrl.prettyUrl());
 } // G3Backend::toPrintout
 
+/*!
+ * KConfigGroup G3Backend::settings ( ) const
+ * @brief Provides the configuration settings of this backend
+ * @return configuration group holding the settings of the remote gallery
+ * Each remote Gallery3 system has its own group inside the slaves
+ * configuration file (kio_gallery3rc), identified by its REST url.
+ * Settings not specified there fall back to the defaults in utility/defines.h.
+ * @see G3Backend
+ * @author Christian Reiner
+ */
+KConfigGroup G3Backend::settings ( ) const
+{
+  return KGlobal::config()->group ( m->restUrl.url() );
+} // G3Backend::settings
+
+/*!
+ * KMimeType::Ptr G3Backend::mimetype ( const QString& name )
+ * @brief Provides an interned mimetype
+ * @param  name name of the mimetype
+ * @return      the mimetype, the default mimetype if the name is unknown
+ * Each mimetype is looked up in the mimetype database only once per backend,
+ * all items of that mimetype share the same object.
+ * @see G3Backend
+ * @author Christian Reiner
+ */
+KMimeType::Ptr G3Backend::mimetype ( const QString& name )
+{
+  QHash<QString,KMimeType::Ptr>::const_iterator it = m->mimetypes.constFind ( name );
+  if ( m->mimetypes.constEnd()!=it )
+    return it.value();
+  KMimeType::Ptr mimetype = KMimeType::mimeType ( name );
+  if ( mimetype.isNull() )
+    mimetype = KMimeType::defaultMimeTypePtr ( );
+  kDebug() << "interning mimetype" << name << "as" << mimetype->name();
+  m->mimetypes.insert ( name, mimetype );
+  return mimetype;
+} // G3Backend::mimetype
+
+/*!
+ * const QString G3Backend::intern ( const QString& string )
+ * @brief Provides an interned copy of a string
+ * @param  string the string to be interned
+ * @return        a shallow copy of the equal string interned before, or of the string itself
+ * Strings repeated in the descriptions of many items, like the templates of
+ * their urls, are stored only once per backend. Qt's implicit sharing makes
+ * all copies handed out refer to the same data.
+ * @see G3Backend
+ * @author Christian Reiner
+ */
+const QString G3Backend::intern ( const QString& string )
+{
+  QSet<QString>::const_iterator it = m->strings.constFind ( string );
+  if ( m->strings.constEnd()!=it )
+    return *it;
+  m->strings.insert ( string );
+  return string;
+} // G3Backend::intern
+
 //==========
 
 /*!
@@ -220,8 +326,12 @@ G3Item* G3Backend::itemById ( g3index id )
 {
   KDebug::Block block ( "G3Backend::itemById" );
   kDebug() << "(<id>)" << id;
-  if ( m->items.contains(id) )
-    return m->items[id];
+  G3Item* known = m->items.value ( id );
+  if ( NULL!=known )
+  {
+    touchItem ( known );
+    return known;
+  }
   // item not yet known, try to request it from the gallery server
   return item ( id );
 } // G3Backend::itemById
@@ -262,8 +372,10 @@ G3Item* G3Backend::itemByPath ( const QString& path )
 {
   KDebug::Block block ( "G3Backend::itemByPath" );
   kDebug() << "(<path>)" << path;
-  QStringList breadcrumbs = path.split(QLatin1String("/"));
-  return itemByPath ( breadcrumbs );
+  G3Item* item = findItemByPath ( path );
+  if ( NULL==item )
+    throw Exception ( Error(ERR_DOES_NOT_EXIST), path );
+  return item;
 } // G3Backend::itemByPath
 
 /*!
@@ -281,18 +393,81 @@ G3Item* G3Backend::itemByPath ( const QString& path )
 G3Item* G3Backend::itemByPath ( const QStringList& breadcrumbs )
 {
   KDebug::Block block ( "G3Backend::itemByPath" );
+  kDebug() << "(<breadcrumbs>)"<< breadcrumbs.join(QLatin1String("|"));
+  G3Item* item = findItemByPath ( breadcrumbs );
+  if ( NULL==item )
+    throw Exception ( Error(ERR_DOES_NOT_EXIST), breadcrumbs.join(QLatin1String("/")) );
+  kDebug() << "{<item>}" << item->toPrintout();
+  return item;
+} // G3Backend::itemByPath
+
+/*!
+ * G3Item* G3Backend::findItemByPath ( const QString& path )
+ * @brief Looks up an item inside a backends item hierarchy
+ * @param path local item path inside the folder hierarchy
+ * @return     pointer to the item associated with the given path, NULL if there is no such item
+ * Paths resolved before are taken from a memo holding the ids of the items
+ * they lead to and through. The memo is bounded by ITEM_PATH_MEMO. Whenever
+ * an item is removed from the backend or refreshed, which includes items
+ * being deleted, moved or renamed, the paths leading to or through it are
+ * forgotten, so a remembered path is always valid.
+ * @see G3Backend
+ * @author Christian Reiner
+ */
+G3Item* G3Backend::findItemByPath ( const QString& path )
+{
+  kDebug() << "(<path>)" << path;
+  QHash<QString,QVector<g3index> >::const_iterator memo = m->paths.constFind ( path );
+  if ( m->paths.constEnd()!=memo )
+  {
+    G3Item* item = m->items.value ( memo.value().first() );
+    touchItem ( item );
+    return item;
+  }
+  G3Item* item = findItemByPath ( path.split(QLatin1String("/")) );
+  if ( NULL!=item )
+  {
+    if ( m->paths.count()>=ITEM_PATH_MEMO )
+    {
+      m->paths.clear  ( );
+      m->routes.clear ( );
+    }
+    // the item comes first, followed by its ancestors
+    QVector<g3index> route;
+    for ( G3Item* step=item; NULL!=step; step=step->parent() )
+    {
+      route << step->id ( );
+      m->routes.insert ( step->id(), path );
+    }
+    m->paths.insert ( path, route );
+  }
+  return item;
+} // G3Backend::findItemByPath
+
+/*!
+ * G3Item* G3Backend::findItemByPath ( const QStringList& breadcrumbs )
+ * @brief Looks up an item inside a backends item hierarchy
+ * @param breadcrumbs local item pathinside the folder hierarchy
+ * @return            pointer to the item associated with the given url, NULL if there is no such item
+ * Like itemByPath(), but a path that does not exist is not treated as an
+ * error. Meant for lookups that miss regularly, like the probes of file
+ * managers for files like '.directory'.
+ * @see G3Backend
+ * @author Christian Reiner
+ */
+G3Item* G3Backend::findItemByPath ( const QStringList& breadcrumbs )
+{
   kDebug() << "(<breadcrumbs>)"<< breadcrumbs.join(QLatin1String("|"));
   // start at the 'root' album
   G3Item* item = itemBase ( );
   QList<QString>::const_iterator it;
   // descend into the album hierarchy one by one along the breadcrumbs path
-  for ( it=breadcrumbs.constBegin(); it!=breadcrumbs.constEnd(); it++)
+  for ( it=breadcrumbs.constBegin(); NULL!=item && it!=breadcrumbs.constEnd(); it++)
     // skip empty names, this might come from processing an absolute path or because of double slashes in paths
     if ( ! it->isEmpty() )
-      item = item->member ( *it );
-  kDebug() << "{<item>}" << item->toPrintout();
+      item = item->findMember ( *it );
   return item;
-} // G3Backend::itemByPath
+} // G3Backend::findItemByPath
 
 /*!
  * QList<G3Item*> G3Backend::membersByItemId ( g3index id )
@@ -311,15 +486,9 @@ QList<G3Item*> G3Backend::membersByItemId ( g3index id )
 {
   KDebug::Block block ( "G3Backend::membersByItemId" );
   kDebug() << "(<id>)" << id;
-  G3Item* parent = itemById ( id );
-  QList<G3Item*> items = G3Request::g3GetItems ( this, id );
-  // process url list, generate items and sort them into this backends item cache
-  foreach ( G3Item* item, items )
-  {
-    if ( parent->containsMember(item->id()) )
-      parent->popMember ( item );
-    parent->pushMember ( item );
-  } // foreach
+  // all missing members are retrieved in parallel chunks
+  QList<G3Item*> items = itemById(id)->members().values();
+  kDebug() << "{<items[count]>}" << items.count();
   return items;
 } // G3Backend::membersByItemId
 
@@ -369,15 +538,9 @@ QList<G3Item*> G3Backend::membersByItemPath ( const QStringList& breadcrumbs )
 {
   KDebug::Block block ( "G3Backend::membersByItemPath" );
   kDebug() << "(<breadcrumbs>)" << breadcrumbs.join(QLatin1String("|"));
-  G3Item* parent = itemByPath ( breadcrumbs );
-  QList<G3Item*> items = G3Request::g3GetItems ( this, QStringList(QString("%1/item/%2").arg(m->restUrl.url()).arg(parent->id())) );
-  // process url list, generate items and sort them into this backends item cache
-  foreach ( G3Item* item, items )
-  {
-    if ( parent->containsMember(item->id()) )
-      parent->popMember ( item );
-    parent->pushMember ( item );
-  } // foreach
+  // all missing members are retrieved in parallel chunks
+  QList<G3Item*> items = itemByPath(breadcrumbs)->members().values();
+  kDebug() << "{<items[count]>}" << items.count();
   return items;
 } // G3Backend::membersByItemPath
 
@@ -398,14 +561,58 @@ G3Item* G3Backend::item ( g3index id )
 {
   KDebug::Block block ( "G3Backend::item" );
   kDebug() << "(<id>)" << id;
-  if ( m->items.contains(id) )
-    return m->items[id];
-  // item not found, retrieve it from the remote gallery
-  G3Item* item = G3Request::g3GetItem ( this, id );
+  G3Item* known = m->items.value ( id );
+  if ( NULL!=known )
+    return known;
+  // item not found, maybe it has been cached during an earlier session
+  G3Item* item = itemCached ( id );
+  // item not cached either, retrieve it from the remote gallery
+  // all missing ancestors are retrieved by the same request
+  if ( NULL==item )
+    item = G3Request::g3GetAncestry ( this, id );
   kDebug() << "{<item>}" << item->toPrintout();
   return item;
 } // G3Backend::item
 
+/*!
+ * G3Item* G3Backend::itemCached ( g3index id, bool shared )
+ * @brief Instantiates an item from the local cache
+ * @param id     numeric item id
+ * @param shared ask the cache service if no valid record is cached locally
+ * @return       pointer to the item object or NULL if no valid record is cached
+ * Creates an item from the description stored in the local cache file without
+ * contacting the remote gallery. The item is registered and integrated into
+ * the item hierarchy like any retrieved item. Note that the item must not be
+ * registered yet.
+ * @see G3Backend
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+G3Item* G3Backend::itemCached ( g3index id, bool shared )
+{
+  KDebug::Block block ( "G3Backend::itemCached" );
+  kDebug() << "(<id> <shared>)" << id << shared;
+  QVariantMap attributes;
+  uint        fetched;
+  if ( NULL==m->cache || ! m->cache->lookup(id,attributes,&fetched,shared) )
+    return NULL;
+  try
+  {
+    G3Item* item = G3Item::instantiate ( this, attributes );
+    // the description is as old as the cached record
+    item->setFetched ( fetched );
+    kDebug() << "{<item>}" << item->toPrintout();
+    return item;
+  }
+  catch ( Exception e )
+  {
+    // an unusable record, forget about it
+    kDebug() << "dropping unusable cache record:" << e.getText();
+    m->cache->drop ( id );
+    return NULL;
+  }
+} // G3Backend::itemCached
+
 /*!
  * QHash<g3index,G3Item*> G3Backend::members ( g3index id )
  * @brief Provides a list of member items of an item inside a backends item hierarchy
@@ -419,7 +626,7 @@ QHash<g3index,G3Item*> G3Backend::members ( g3index id )
 {
   KDebug::Block block ( "G3Backend::members" );
   kDebug() << "(<id>)" << id;
-  itemById(id)->members ( );
+  return itemById(id)->members ( );
 } // G3Backend::members
 
 /*!
@@ -464,13 +671,19 @@ int G3Backend::countItems  ( )
  * Performs a G3 specific authentication request. 
  * Goal is to get back the 'remote access key' that is used by the G§ REST API as a kind of long-term-session-keys. 
  * Upon success that key is stored inside the authentication credential as 'digestInfo'. 
+ * The item cache is switched to the user logged in.
  * @see G3Backend
  * @author Christian Reiner
  */
 bool G3Backend::login ( AuthInfo& credentials )
 {
   kDebug() << "(<credentials>)" << credentials.caption;
-  return G3Request::g3Login ( this, credentials );
+  if ( ! G3Request::g3Login(this,credentials) )
+    return FALSE;
+  // the user logged in might see different items
+  if ( NULL!=m->cache )
+    m->cache->setUser ( credentials.username );
+  return TRUE;
 } // G3Request::g3RemoteAccessKey
 
 /*!
@@ -479,6 +692,7 @@ bool G3Backend::login ( AuthInfo& credentials )
  * @param item pointer to an item object
  * Registeres a given item inside its associated backend. 
  * Note that the backend only holds an unordered list of items, not a hierarchy. 
+ * Each item registered counts as a miss, it had to be constructed.
  * @see G3Backend
  * @author Christian Reiner
  */
@@ -486,6 +700,9 @@ void G3Backend::pushItem ( G3Item* item )
 {
   kDebug() << "(<item>)" << item->toPrintout();
   m->items.insert ( item->id(), item );
+  m->footprint += item->footprint ( );
+  m->misses++;
+  item->touch ( m->clock );
 } // G3Backend::pushItem
 
 /*!
@@ -495,17 +712,229 @@ void G3Backend::pushItem ( G3Item* item )
  * @returns  pointer to the item holding the given id)
  * Deregisteres an existing item from its associated backend and returns a pointer to it. 
  * Note that this does not delete the item object nor does it remove it from the items hierarchy. 
+ * Remembered paths leading to or through the item are forgotten. 
  * @see G3Backend
  * @author Christian Reiner
  */
 G3Item* G3Backend::popItem ( g3index id )
 {
   kDebug() << "(<id>)" << id;
+  forgetPaths ( id );
   if ( m->items.contains(id) )
-    return m->items.take ( id );
+  {
+    G3Item* item = m->items.take ( id );
+    m->footprint -= item->footprint ( );
+    return item;
+  }
   throw Exception ( Error(ERR_INTERNAL), i18n("attempt to remove non-existing item with id '%1'").arg(id) );
 } // G3Backend::popItem
 
+/*!
+ * void G3Backend::resizeItem ( G3Item* item, int footprint )
+ * @brief Accounts for an item that has been described anew in place
+ * @param item      pointer to the item refreshed
+ * @param footprint the footprint of the item before
+ * Remembered paths leading to or through the item are forgotten, since the
+ * item might have been renamed or moved.
+ * @see G3Item::refresh
+ * @see G3Backend
+ * @author Christian Reiner
+ */
+void G3Backend::resizeItem ( G3Item* item, int footprint )
+{
+  kDebug() << "(<item> <footprint>)" << item->toPrintout() << footprint;
+  forgetPaths ( item->id() );
+  m->footprint += item->footprint() - footprint;
+} // G3Backend::resizeItem
+
+/*!
+ * void G3Backend::forgetPaths ( g3index id )
+ * @brief Drops the remembered paths leading to or through an item
+ * @param id numeric item id
+ * The paths are found by the reverse index of the memo, so only the paths
+ * of the item and its descendants are forgotten, all other paths stay valid.
+ * @see G3Backend::findItemByPath
+ * @see G3Backend
+ * @author Christian Reiner
+ */
+void G3Backend::forgetPaths ( g3index id )
+{
+  // every remembered path leads through the base item
+  if ( 1==id )
+  {
+    m->paths.clear  ( );
+    m->routes.clear ( );
+    return;
+  }
+  foreach ( const QString& path, m->routes.values(id) )
+    foreach ( g3index step, m->paths.take(path) )
+      m->routes.remove ( step, path );
+} // G3Backend::forgetPaths
+
+/*!
+ * void G3Backend::touchItem ( G3Item* item )
+ * @brief Marks an item as used by the current command
+ * @param item pointer to the item looked up
+ * Stamps the item and all its ancestors, so an album is never less recently
+ * used than any item inside it. Counts as a hit. The items are remembered
+ * to be revalidated once the slave is idle.
+ * @see G3Backend
+ * @author Christian Reiner
+ */
+void G3Backend::touchItem ( G3Item* item )
+{
+  m->hits++;
+  for ( ; NULL!=item; item=item->parent() )
+  {
+    item->touch ( m->clock );
+    m->used.insert ( item->id() );
+  }
+} // G3Backend::touchItem
+
+/*!
+ * void G3Backend::evictItems ( )
+ * @brief Keeps the items within the memory budget
+ * Meant to be called between two commands, when no item is in use.
+ * While the estimated footprint of all items exceeds the budget the members
+ * of the least recently used albums are deleted, including their subtrees.
+ * Albums themselves are kept with the ids of their members, so the path
+ * from the base item to any remaining item stays intact and evicted members
+ * are transparently retrieved again, typically from the local cache, when
+ * they are accessed next time. Albums used by the last command are spared.
+ * Each call starts a new command stamp.
+ * @see G3Backend
+ * @author Christian Reiner
+ */
+void G3Backend::evictItems ( )
+{
+  if ( 0<m->budget && m->footprint>m->budget )
+  {
+    KDebug::Block block ( "G3Backend::evictItems" );
+    kDebug() << "(<footprint> <budget>)" << m->footprint << m->budget;
+    // albums holding members, least recently used first
+    QVector<QPair<uint,g3index> > albums;
+    for ( G3ItemTable::const_iterator it=m->items.constBegin(); it!=m->items.constEnd(); ++it )
+      if ( 0<(*it)->countMembersPresent() && m->clock!=(*it)->touched() )
+        albums << qMakePair ( (*it)->touched(), (*it)->id() );
+    qSort ( albums );
+    const int count = m->items.count ( );
+    for ( int pos=0; pos<albums.count() && m->footprint>m->budget; pos++ )
+    {
+      // the album might have been evicted as part of an album evicted before
+      G3Item* album = m->items.value ( albums.at(pos).second );
+      if ( NULL!=album )
+        album->evictMembers ( );
+    } // for
+    m->evictions += count - m->items.count();
+    kDebug() << "evicted" << count-m->items.count() << "items, footprint now" << m->footprint;
+  } // if
+  kDebug() << "{<items> <hits> <misses> <evictions>}" << m->items.count() << m->hits << m->misses << m->evictions;
+  m->clock++;
+} // G3Backend::evictItems
+
+/*!
+ * bool G3Backend::revalidateItems ( int limit )
+ * @brief Revalidates the items used by the last commands
+ * @param  limit number of items revalidated at most, roughly, 0 for no limit
+ * @return       TRUE if used items are left to be revalidated, FALSE otherwise
+ * Meant to be called when the slave is idle, so the items kept in memory are
+ * served right away and revalidated afterwards, a limited number at a time.
+ * Items used by the commands and the members present of albums used by them
+ * are revalidated when they have passed the time to live of their type.
+ * Items that have been considered are not considered again before they are
+ * used again, even if their revalidation fails. Their descriptions are
+ * retrieved again and compared: unchanged items are marked as fetched,
+ * changed items are refreshed in place, keeping all members still described.
+ * An item missing from the reply is only removed once the remote system
+ * confirms that it does not exist anymore, items might be missing simply
+ * because the session cannot see them.
+ * There is no job to ask the user for credentials at this point, so no
+ * request is repeated after an authentication.
+ * @see G3Backend
+ * @author Christian Reiner
+ */
+bool G3Backend::revalidateItems ( int limit )
+{
+  const uint now = QDateTime::currentDateTime().toTime_t();
+  QStringList     urls;
+  QSet<g3index>   stale;
+  // the members of an album are considered together, so the limit might be exceeded
+  QSet<g3index>::iterator used = m->used.begin ( );
+  while ( m->used.end()!=used && ( 0>=limit || urls.count()<limit ) )
+  {
+    G3Item* item = m->items.value ( *used );
+    used = m->used.erase ( used );
+    if ( NULL==item )
+      continue;
+    QList<G3Item*> items = item->membersPresent ( );
+    items << item;
+    foreach ( G3Item* candidate, items )
+    {
+      const uint ttl = m->ttl[candidate->type().toInt()];
+      if ( 0<ttl && candidate->fetched()+ttl<=now && ! stale.contains(candidate->id()) )
+      {
+        stale.insert ( candidate->id() );
+        urls << candidate->restUrl().url();
+      }
+    } // foreach
+  } // while
+  if ( stale.isEmpty() )
+    return hasUsedItems ( );
+  KDebug::Block block ( "G3Backend::revalidateItems" );
+  kDebug() << "revalidating" << stale.count() << "items," << m->used.count() << "used items left";
+  m->interactive = FALSE;
+  try
+  {
+    QHash<g3index,QVariantMap> changed;
+    foreach ( const QVariantMap& description, G3Request::g3GetDescriptions(this,urls) )
+    {
+      const g3index id = description.value(QLatin1String("entity")).toMap().value(QLatin1String("id")).toUInt();
+      G3Item* item = m->items.value ( id );
+      if ( NULL==item || ! stale.remove(id) )
+        continue;
+      // the fresh description is used when the item is constructed next time
+      if ( m->cache )
+        m->cache->store ( id, description );
+      if ( item->matches(description) )
+        item->setFetched ( now );
+      else
+        changed.insert ( id, description );
+    } // foreach
+    kDebug() << changed.count() << "items changed";
+    for ( QHash<g3index,QVariantMap>::const_iterator it=changed.constBegin(); it!=changed.constEnd(); it++ )
+    {
+      // the item might have been deleted as a member not described anymore
+      G3Item* item = m->items.value ( it.key() );
+      if ( NULL!=item )
+        item->refresh ( it.value() );
+    }
+    // items still stale have not been described, maybe they do not exist anymore
+    foreach ( g3index id, stale )
+    {
+      G3Item* item = m->items.value ( id );
+      if ( NULL==item || G3Request::g3ExistsItem(this,id) )
+        continue;
+      kDebug() << "item" << item->toPrintout() << "vanished";
+      if ( m->cache )
+        m->cache->drop ( id );
+      if ( item->parent() )
+      {
+        if ( m->cache )
+          m->cache->drop ( item->parent()->id() );
+        item->parent()->removeMemberId ( id );
+      }
+      delete item;
+    } // foreach
+  } // try
+  catch ( Exception e )
+  {
+    m->interactive = TRUE;
+    throw e;
+  } // catch
+  m->interactive = TRUE;
+  return hasUsedItems ( );
+} // G3Backend::revalidateItems
+
 /*!
  * void G3Backend::removeItem ( G3Item* item )
  * @brief removes an item from the backends item hierarchy
@@ -524,16 +953,18 @@ void G3Backend::removeItem ( G3Item* item )
     throw Exception ( Error(ERR_WRITE_ACCESS_DENIED),item->toPrintout() );
   G3Request::g3DelItem ( this, item->id() );
   G3Item* parent = item->parent();
+  if ( m->cache )
+    m->cache->drop ( item->id() );
   if ( parent )
   {
-    // we delete the parent folder to create a fresh state
-    QStringList breadcrumbs = parent->path();
-    delete parent;
-    parent = NULL;
-    // now try to get the fresh item, this will re-construct the parent on-the-fly
-    parent = itemByPath ( breadcrumbs );
+    // patch the parents description instead of retrieving it again
+    parent->removeMemberId ( item->id() );
+    if ( m->cache )
+      m->cache->drop ( parent->id() );
     kDebug() << "deleted item in album" << parent->toPrintout();
   }
+  // this also unlinks the item from its parent
+  delete item;
 } // G3Backend::removeItem
 
 /*!
@@ -544,6 +975,11 @@ void G3Backend::removeItem ( G3Item* item )
  * @return           pointer to updated item object
  * Updates an existing item on the remote server side by altering some of its attributes. 
  * Note that this list might include the parent item, so in fact it can move the item inside the hierarchy. 
+ * The item is updated in place from its fresh description: it is moved from
+ * the old parent into the new one and only the member ids of these two albums
+ * are patched, so neither the item nor its members have to be constructed
+ * again.
+ * @see G3Item::refresh
  * @see G3Backend
  * @author Christian Reiner
  */
@@ -555,22 +991,20 @@ G3Item* const G3Backend::updateItem ( G3Item* item, const QHash<QString,QString>
   if ( ! item->canEdit() )
     throw Exception ( Error(ERR_WRITE_ACCESS_DENIED),item->toPrintout() );
   G3Request::g3PutItem ( this, item->id(), attributes );
-  // refresh old parent item
-  G3Item* parent = item->parent ( );
-  QStringList breadcrumbs = parent->path();
-  delete parent;
-  parent = NULL;
-  parent = itemByPath ( breadcrumbs );
-  // refresh new parent item, if this was a move
-  if ( attributes.contains(QLatin1String("parent")) )
+  // the reply of the update does not describe the item, so the description is retrieved
+  QList<QVariantMap> descriptions = G3Request::g3GetDescriptions ( this, QStringList(item->restUrl().url()) );
+  if ( descriptions.isEmpty() )
+    throw Exception ( Error(ERR_DOES_NOT_EXIST), item->toPrintout() );
+  // the cached descriptions of the item and its old and new parent are outdated
+  if ( m->cache )
   {
-    g3index id = QVariant(KUrl(attributes[QLatin1String("parent")]).fileName()).toInt();
-    parent = itemById ( id );
-    QStringList breadcrumbs = parent->path();
-    delete parent;
-    parent = NULL;
-    parent = itemByPath ( breadcrumbs );
-  } // if
+    m->cache->store ( item->id(), descriptions.first() );
+    if ( item->parent() )
+      m->cache->drop ( item->parent()->id() );
+    if ( attributes.contains(QLatin1String("parent")) )
+      m->cache->drop ( G3Item::idFromUrl(attributes[QLatin1String("parent")]) );
+  }
+  item->refresh ( descriptions.first() );
   return item;
 } // G3Backend::updateItem
 
@@ -584,6 +1018,9 @@ G3Item* const G3Backend::updateItem ( G3Item* item, const QHash<QString,QString>
  * Creates an item inside the remote gallery system, be it an album, a photo or a movie. 
  * This creation consists of the node created, some attributes for its description and. 
  * In a local file in case of a photo or movie item. 
+ * Only the created item is retrieved and linked into its parent, neither the
+ * parent nor any other ancestor is retrieved again, so uploading many files
+ * into an album does not transfer the albums list of members each time.
  * @see G3Backend
  * @author Christian Reiner
  */
@@ -609,13 +1046,17 @@ G3Item* const G3Backend::createItem  ( G3Item* parent, const QString& name, cons
     attributes.insert ( QLatin1String("mime_type"), QLatin1String("inode/directory") );
   }
   // send request
-  G3Request::g3PostItem ( this, parent->id(), attributes, file );
-  // we delete the parent folder to create a fresh start including parent and new member
-  QStringList breadcrumbs = parent->path() << name;
-  delete parent;
-  parent = NULL;
-  // now try to get the fresh item, this will re-construct the parent on-the-fly
-  G3Item* item = itemByPath ( breadcrumbs );
+  QString url = G3Request::g3PostItem ( this, parent->id(), attributes, file );
+  if ( m->cache )
+    m->cache->drop ( parent->id() );
+  // patch the parents description and retrieve only the new item, not its ancestry
+  // note: constructing the item pushes it into its parent
+  const g3index id = G3Item::idFromUrl ( url );
+  parent->addMemberId ( id );
+  QList<G3Item*> items = G3Request::g3GetItems ( this, QStringList(url) );
+  if ( items.isEmpty() )
+    throw Exception ( Error(ERR_DOES_NOT_EXIST), url );
+  G3Item* item = items.first ( );
   kDebug() << "created item" << item->toPrintout();
   return item;
 } // G3Backend::createItem
@@ -17,16 +17,26 @@
 #define G3_BACKEND_H
 
 #include <QHash>
+#include <QSet>
+#include <QVector>
+#include <kmimetype.h>
+#include <kconfiggroup.h>
 #include <ktemporaryfile.h>
 #include <kio/authinfo.h>
 #include "utility/defines.h"
+#include "gallery3/g3_chunking.h"
+#include "gallery3/g3_item_table.h"
+#include "entity/g3_type.h"
 
 namespace KIO
 {
   namespace Gallery3
   {
     class G3Item;
+    class G3ItemPool;
     class G3File;
+    class G3Pipeline;
+    class G3Cache;
 
     /*!
      * @class G3Backend
@@ -44,16 +54,34 @@ namespace KIO
       class Members
       {
         public:
-        inline Members ( const KUrl& g3Url ) : baseUrl(g3Url) { }
+        inline Members ( const KUrl& g3Url ) : baseUrl(g3Url), pipeline(NULL), cache(NULL), footprint(0), budget(0), clock(1), hits(0), misses(0), evictions(0), pool(NULL), interactive(TRUE) { }
         AuthInfo               credentials;
         const KUrl             baseUrl;
         KUrl                   restUrl;
-        QHash<g3index,G3Item*> items;
+        G3ItemTable            items;
+        G3Pipeline*            pipeline;
+        G3Chunking             chunking;
+        G3Cache*               cache;
+        QHash<QString,QVector<g3index> > paths;  // memo of resolved paths: ids of the item and its ancestors
+        QMultiHash<g3index,QString>      routes; // memo of resolved paths, by the ids of the items along them
+        QHash<QString,KMimeType::Ptr> mimetypes; // interned mimetypes, by name
+        QSet<QString>          strings;   // interned strings shared by many items
+        qint64                 footprint; // estimated memory held by all items, in bytes
+        qint64                 budget;    // footprint the items are kept within, 0 for unlimited
+        uint                   clock;     // stamp of the current command, see G3Item::touched()
+        quint64                hits;      // lookups answered by a registered item
+        quint64                misses;    // items that had to be constructed
+        quint64                evictions; // items deleted to keep within the budget
+        QSet<g3index>          used;      // items used by the current command
+        G3ItemPool*            pool;      // the private members of all items are taken from here
+        uint                   ttl[G3Type::COMMENT+1]; // time to live of items in memory, by type
+        bool                   interactive; // the user can be asked for credentials
       }; // struct Members
       Q_OBJECT
       private:
         Members* const m;
       protected:
+        void forgetPaths ( g3index id );
       public:
         static G3Backend* const instantiate ( QObject* parent, QHash<QString,G3Backend*>& backends, const KUrl g3Url );
         G3Backend ( QObject* parent, const KUrl& g3Url );
@@ -64,13 +92,29 @@ namespace KIO
         inline AuthInfo&                     credentials ( )       { return m->credentials; }
         inline const KUrl&                   baseUrl     ( ) const { return m->baseUrl;     }
         inline const KUrl&                   restUrl     ( ) const { return m->restUrl;     }
-        inline const QHash<g3index,G3Item*>& items       ( ) const { return m->items;       }
+        inline const G3ItemTable&            items       ( ) const { return m->items;       }
+        inline G3Pipeline*                   pipeline    ( ) const { return m->pipeline;    }
+        inline G3Chunking&                   chunking    ( )       { return m->chunking;    }
+        inline G3Cache*                      cache       ( ) const { return m->cache;       }
+        inline qint64                        footprint   ( ) const { return m->footprint;   }
+        inline quint64                       hits        ( ) const { return m->hits;        }
+        inline quint64                       misses      ( ) const { return m->misses;      }
+        inline quint64                       evictions   ( ) const { return m->evictions;   }
+        inline bool                          isInteractive ( ) const { return m->interactive; }
+        inline G3ItemPool&                   itemPool      ( )       { return *m->pool;      }
+        inline bool                          hasUsedItems  ( ) const { return ! m->used.isEmpty(); }
+        KConfigGroup                         settings    ( ) const;
+        KMimeType::Ptr                       mimetype    ( const QString& name );
+        const QString                        intern      ( const QString& string );
         G3Item*                              item       ( g3index id );
+        G3Item*                              itemCached ( g3index id, bool shared=TRUE );
         G3Item*                              itemBase   ( );
         G3Item*                              itemById   ( g3index id );
         G3Item*                              itemByUrl  ( const KUrl& itemUrl );
         G3Item*                              itemByPath ( const QString& path );
         G3Item*                              itemByPath ( const QStringList& breadcrumbs );
+        G3Item*                              findItemByPath ( const QString& path );
+        G3Item*                              findItemByPath ( const QStringList& breadcrumbs );
         QHash<g3index,G3Item*>               members           ( g3index id );
         QHash<g3index,G3Item*>               members           ( G3Item* item );
         QList<G3Item*>                       membersByItemId   ( g3index id );
@@ -80,6 +124,10 @@ namespace KIO
         bool                                 login       ( AuthInfo& credentials );
         void                                 pushItem    ( G3Item* item );
         G3Item*                              popItem     ( g3index id );
+        void                                 touchItem   ( G3Item* item );
+        void                                 resizeItem  ( G3Item* item, int footprint );
+        void                                 evictItems  ( );
+        bool                                 revalidateItems ( int limit=0 );
         void                                 removeItem  ( G3Item* item );
         G3Item* const                        updateItem  ( G3Item* item, const QHash<QString,QString>& attributes );
         G3Item* const                        createItem  ( G3Item* parent, const QString& name, const G3File* const file=NULL );
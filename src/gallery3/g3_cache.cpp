@@ -0,0 +1,470 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * @brief Implements the methods of class G3Cache
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QtEndian>
+#include <kdebug.h>
+#include <klockfile.h>
+#include <ksavefile.h>
+#include <kstandarddirs.h>
+#include "gallery3/g3_cache.h"
+#include "gallery3/g3_cache_client.h"
+
+using namespace KIO;
+using namespace KIO::Gallery3;
+
+/*!
+ * G3Cache::G3Cache ( const KUrl& baseUrl, const QString& user, uint ttl, bool shared )
+ * @brief Constructor
+ * @param baseUrl base url of the backend the cache works for
+ * @param user    name of the user logged in, empty for anonymous access
+ * @param ttl     time to live of cached records in seconds
+ * @param shared  exchange records with the cache service
+ * Credentials contained in the base url are ignored, the cache is bound to
+ * the given user instead.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+G3Cache::G3Cache ( const KUrl& baseUrl, const QString& user, uint ttl, bool shared )
+  : m ( new G3Cache::Members(ttl,shared) )
+{
+  KDebug::Block block ( "G3Cache::G3Cache" );
+  KUrl url ( baseUrl );
+  url.setUser ( QString() );
+  url.setPass ( QString() );
+  m->url = url.url ( );
+  kDebug() << "(<url> <user> <ttl> <shared>)" << m->url << user << ttl << shared;
+  bind ( user );
+} // G3Cache::G3Cache
+
+/*!
+ * G3Cache::~G3Cache ( )
+ * @brief Destructor
+ * Writes all pending records to disk.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+G3Cache::~G3Cache ( )
+{
+  KDebug::Block block ( "G3Cache::~G3Cache" );
+  kDebug() << "(<>)";
+  flush ( );
+  close ( );
+  delete m->service;
+  // delete private members
+  delete m;
+} // G3Cache::~G3Cache
+
+/*!
+ * void G3Cache::bind ( const QString& user )
+ * @brief Binds the cache to the file of a user
+ * @param user name of the user logged in, empty for anonymous access
+ * The cache file is named after a hash of the base url and the user name, so
+ * different galleries and different users of the same gallery, which might
+ * see different items, use separate files.
+ * Note that the file is not touched before it is actually required.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+void G3Cache::bind ( const QString& user )
+{
+  m->user     = user;
+  m->gallery  = QCryptographicHash::hash(QString("%1 %2").arg(user).arg(m->url).toUtf8(),QCryptographicHash::Md5).toHex();
+  m->filename = KStandardDirs::locateLocal ( "cache", QString("kio_gallery3/%1.cache").arg(m->gallery), TRUE );
+  m->file.setFileName ( m->filename );
+  m->attempted = FALSE;
+  delete m->service;
+  m->service = m->shared ? new G3CacheClient(m->gallery) : NULL;
+  kDebug() << "cache file" << m->filename;
+} // G3Cache::bind
+
+/*!
+ * void G3Cache::setUser ( const QString& user )
+ * @brief Switches the cache to another user
+ * @param user name of the user logged in
+ * Used after a login, since the new user might see different items. Pending
+ * records are flushed to the file of the previous user, records that cannot
+ * be written are discarded.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+void G3Cache::setUser ( const QString& user )
+{
+  KDebug::Block block ( "G3Cache::setUser" );
+  kDebug() << "(<user>)" << user;
+  if ( user==m->user )
+    return;
+  flush ( );
+  close ( );
+  m->pending.clear ( );
+  m->dropped.clear ( );
+  bind ( user );
+} // G3Cache::setUser
+
+//==========
+
+/*!
+ * bool G3Cache::open ( )
+ * @brief Maps the cache file into memory
+ * @return TRUE if a valid cache file has been mapped, FALSE otherwise
+ * Only a single attempt is made, a missing, outdated or corrupted file is
+ * simply ignored, it will be replaced by the next flush. Closing the file does
+ * not allow another attempt, only replacing the file by a flush does.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+bool G3Cache::open ( )
+{
+  if ( m->attempted )
+    return NULL!=m->map;
+  m->attempted = TRUE;
+  if ( ! m->file.open(QIODevice::ReadOnly) )
+  {
+    kDebug() << "no cache file present";
+    return FALSE;
+  }
+  qint64 size = m->file.size ( );
+  if ( HEADER_SIZE<=size )
+    m->map = m->file.map ( 0, size );
+  if (    NULL!=m->map
+       && MAGIC  ==qFromBigEndian<quint32>(m->map)
+       && VERSION==qFromBigEndian<quint32>(m->map+4) )
+  {
+    m->count = qFromBigEndian<quint32> ( m->map+8 );
+    // the index must fit and each record must lie inside the file
+    bool valid = ( HEADER_SIZE+qint64(m->count)*INDEX_SIZE<=size );
+    for ( quint32 pos=0; valid && pos<m->count; pos++ )
+    {
+      const uchar* index = m->map + HEADER_SIZE + pos*INDEX_SIZE;
+      valid = ( qint64(qFromBigEndian<quint32>(index+4))+qFromBigEndian<quint32>(index+8)<=size );
+    }
+    if ( valid )
+    {
+      kDebug() << "mapped cache file holding" << m->count << "records";
+      return TRUE;
+    }
+  } // if
+  kDebug() << "ignoring invalid cache file" << m->filename;
+  close ( );
+  return FALSE;
+} // G3Cache::open
+
+/*!
+ * void G3Cache::close ( )
+ * @brief Releases a mapped cache file
+ * The attempt to map the file is still remembered, so a file found invalid is
+ * not validated over and over again.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+void G3Cache::close ( )
+{
+  if ( NULL!=m->map )
+    m->file.unmap ( m->map );
+  m->file.close ( );
+  m->map   = NULL;
+  m->count = 0;
+} // G3Cache::close
+
+/*!
+ * int G3Cache::find ( g3index id )
+ * @brief Locates a record inside the mapped cache file
+ * @param  id numeric item id
+ * @return    position inside the index or -1 if there is no such record
+ * Binary search inside the sorted index of the mapped file.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+int G3Cache::find ( g3index id )
+{
+  if ( ! open() )
+    return -1;
+  int lower = 0;
+  int upper = m->count - 1;
+  while ( lower<=upper )
+  {
+    int pos = ( lower + upper ) / 2;
+    quint32 key = qFromBigEndian<quint32> ( m->map + HEADER_SIZE + pos*INDEX_SIZE );
+    if ( key<id )
+      lower = pos + 1;
+    else if ( key>id )
+      upper = pos - 1;
+    else
+      return pos;
+  } // while
+  return -1;
+} // G3Cache::find
+
+/*!
+ * G3Cache::Record G3Cache::recordAt ( int pos, bool deep ) const
+ * @brief Reads a record from the mapped cache file
+ * @param  pos  position inside the index
+ * @param  deep copy the serialized attributes instead of referring to the mapped file
+ * @return      the record found at the given position
+ * Unless a deep copy is requested the record is only valid as long as the
+ * cache file is mapped.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+G3Cache::Record G3Cache::recordAt ( int pos, bool deep ) const
+{
+  const uchar* index = m->map + HEADER_SIZE + pos*INDEX_SIZE;
+  const char*  data  = reinterpret_cast<const char*>(m->map) + qFromBigEndian<quint32>(index+4);
+  int          size  = qFromBigEndian<quint32> ( index+8 );
+  Record record;
+  record.fetched = qFromBigEndian<quint32> ( index+12 );
+  record.updated = qFromBigEndian<quint32> ( index+16 );
+  record.blob    = deep ? QByteArray(data,size) : QByteArray::fromRawData(data,size);
+  return record;
+} // G3Cache::recordAt
+
+/*!
+ * bool G3Cache::record ( g3index id, Record& record )
+ * @brief Provides the current record of an item
+ * @param  id     numeric item id
+ * @param  record the record found
+ * @return        TRUE if a record exists, FALSE otherwise
+ * Pending records take precedence over those inside the cache file. Records
+ * read from the file refer to the mapped file, they are only valid as long as
+ * the file is mapped.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+bool G3Cache::record ( g3index id, Record& record )
+{
+  if ( m->pending.contains(id) )
+  {
+    record = m->pending[id];
+    return TRUE;
+  }
+  if ( m->dropped.contains(id) )
+    return FALSE;
+  int pos = find ( id );
+  if ( 0>pos )
+    return FALSE;
+  record = recordAt ( pos );
+  return TRUE;
+} // G3Cache::record
+
+//==========
+
+/*!
+ * bool G3Cache::lookup ( g3index id, QVariantMap& attributes, uint* fetched, bool shared )
+ * @brief Provides the cached description of an item
+ * @param  id         numeric item id
+ * @param  attributes the items description as retrieved from the remote system earlier
+ * @param  fetched    receives the time the description was retrieved, if specified
+ * @param  shared     ask the cache service for records missing locally
+ * @return            TRUE if a valid record exists, FALSE otherwise
+ * Records are handed out without consulting the remote system as long as
+ * they have not passed their time to live, so remote changes are noticed
+ * after that time at the latest. Older records are not handed out, the item
+ * has to be retrieved again, which replaces its record. Records missing
+ * locally are requested from the cache service, if that is available and
+ * unless the caller has done so already by prefetch().
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+bool G3Cache::lookup ( g3index id, QVariantMap& attributes, uint* fetched, bool shared )
+{
+  kDebug() << "(<id> <shared>)" << id << shared;
+  Record entry;
+  quint32 now = QDateTime::currentDateTime().toTime_t();
+  if ( ! record(id,entry) || entry.fetched+m->ttl<now )
+  {
+    // another slave might have retrieved the item meanwhile
+    if ( ! shared || 0==prefetch(QVector<g3index>()<<id) || ! record(id,entry) )
+    {
+      kDebug() << "no valid record of item" << id;
+      return FALSE;
+    }
+  }
+  if ( NULL!=fetched )
+    *fetched = entry.fetched;
+  QDataStream stream ( entry.blob );
+  stream.setVersion ( QDataStream::Qt_4_7 );
+  stream >> attributes;
+  return ( QDataStream::Ok==stream.status() ) && ! attributes.isEmpty();
+} // G3Cache::lookup
+
+/*!
+ * int G3Cache::prefetch ( const QVector<g3index>& ids )
+ * @brief Adopts the records of items from the cache service
+ * @param  ids numeric ids of the items
+ * @return     number of records adopted
+ * The items without a valid local record are looked up by a single request
+ * to the cache service, valid records known to the service are adopted as
+ * if they had been stored locally. Meant to be called before a list of
+ * items is looked up, so the service is asked once instead of for each item.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+int G3Cache::prefetch ( const QVector<g3index>& ids )
+{
+  if ( NULL==m->service )
+    return 0;
+  Record  entry;
+  quint32 now = QDateTime::currentDateTime().toTime_t();
+  QVector<g3index> missing;
+  foreach ( g3index id, ids )
+    if ( ! record(id,entry) || entry.fetched+m->ttl<now )
+      missing << id;
+  QHash<g3index,Record> records;
+  if ( missing.isEmpty() || ! m->service->lookup(missing,records) )
+    return 0;
+  int count = 0;
+  for ( QHash<g3index,Record>::const_iterator it=records.constBegin(); it!=records.constEnd(); it++ )
+    if ( it.value().fetched+m->ttl>=now )
+    {
+      m->dropped.remove ( it.key() );
+      m->pending.insert ( it.key(), it.value() );
+      count++;
+    }
+  kDebug() << "adopted" << count << "of" << missing.count() << "records from cache service";
+  return count;
+} // G3Cache::prefetch
+
+/*!
+ * void G3Cache::store ( g3index id, const QVariantMap& attributes )
+ * @brief Stores the description of an item
+ * @param id         numeric item id
+ * @param attributes the items description as retrieved from the remote system
+ * The record replaces any previous record of the item, its time to live
+ * starts anew.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+void G3Cache::store ( g3index id, const QVariantMap& attributes )
+{
+  kDebug() << "(<id>)" << id;
+  Record entry;
+  entry.fetched = QDateTime::currentDateTime().toTime_t();
+  entry.updated = attributes.value(QLatin1String("entity")).toMap().value(QLatin1String("updated")).toUInt();
+  QDataStream stream ( &entry.blob, QIODevice::WriteOnly );
+  stream.setVersion ( QDataStream::Qt_4_7 );
+  stream << attributes;
+  m->dropped.remove ( id );
+  m->pending.insert ( id, entry );
+  if ( m->service )
+    m->service->store ( id, entry );
+} // G3Cache::store
+
+/*!
+ * void G3Cache::drop ( g3index id )
+ * @brief Removes the record of an item
+ * @param id numeric item id
+ * Typically used when an item has been altered locally, so the remote system
+ * is consulted again the next time the item is required.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+void G3Cache::drop ( g3index id )
+{
+  kDebug() << "(<id>)" << id;
+  m->pending.remove ( id );
+  m->dropped.insert ( id );
+  if ( m->service )
+    m->service->drop ( id );
+} // G3Cache::drop
+
+/*!
+ * void G3Cache::flush ( )
+ * @brief Writes all pending changes to disk
+ * Merges the pending records with those of the current cache file into a
+ * fresh file which atomically replaces the current one.
+ * Since the whole file is rewritten this is not done while records are
+ * stored but only when the slave is idle or terminates. The file is locked
+ * and mapped again before merging, so records flushed by concurrent slaves
+ * since the file was mapped here are kept. If the lock cannot be acquired the
+ * file is not written at all, the records stay pending.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+void G3Cache::flush ( )
+{
+  KDebug::Block block ( "G3Cache::flush" );
+  kDebug() << "(<>)" << m->pending.count() << "pending" << m->dropped.count() << "dropped";
+  if ( ! isDirty() )
+    return;
+  KLockFile lock ( m->filename+QLatin1String(".lock") );
+  if ( KLockFile::LockOK!=lock.lock() )
+  {
+    // the pending records are kept for the next attempt
+    kDebug() << "failed to lock cache file" << m->filename << ", not writing it";
+    return;
+  }
+  // another slave might have replaced the file since it was mapped
+  close ( );
+  m->attempted = FALSE;
+  // merge current and pending records, QMap keeps them sorted by id
+  QMap<g3index,Record> records = m->pending;
+  if ( open() )
+    for ( quint32 pos=0; pos<m->count; pos++ )
+    {
+      g3index id = qFromBigEndian<quint32> ( m->map + HEADER_SIZE + pos*INDEX_SIZE );
+      if ( ! records.contains(id) && ! m->dropped.contains(id) )
+        records.insert ( id, recordAt(pos,TRUE) );
+    } // for
+  close ( );
+  // layout: header, index, serialized attributes
+  QByteArray index ( HEADER_SIZE + records.count()*INDEX_SIZE, 0 );
+  uchar* pointer = reinterpret_cast<uchar*>(index.data());
+  qToBigEndian<quint32> ( MAGIC,           pointer   );
+  qToBigEndian<quint32> ( VERSION,         pointer+4 );
+  qToBigEndian<quint32> ( records.count(), pointer+8 );
+  pointer += HEADER_SIZE;
+  quint32 offset = index.size ( );
+  QMap<g3index,Record>::const_iterator it;
+  for ( it=records.constBegin(); it!=records.constEnd(); it++, pointer+=INDEX_SIZE )
+  {
+    qToBigEndian<quint32> ( it.key(),              pointer    );
+    qToBigEndian<quint32> ( offset,                pointer+4  );
+    qToBigEndian<quint32> ( it.value().blob.size(), pointer+8  );
+    qToBigEndian<quint32> ( it.value().fetched,    pointer+12 );
+    qToBigEndian<quint32> ( it.value().updated,    pointer+16 );
+    offset += it.value().blob.size ( );
+  } // for
+  KSaveFile file ( m->filename );
+  if ( file.open(QIODevice::WriteOnly) )
+  {
+    file.write ( index );
+    for ( it=records.constBegin(); it!=records.constEnd(); it++ )
+      file.write ( it.value().blob );
+    if ( file.finalize() )
+      kDebug() << "wrote" << records.count() << "records to cache file" << m->filename;
+    else
+      kDebug() << "failed to write cache file" << m->filename << file.errorString();
+  }
+  else
+    kDebug() << "failed to open cache file" << m->filename << file.errorString();
+  // the cache file has been replaced, it is mapped again when required
+  m->attempted = FALSE;
+  m->pending.clear ( );
+  m->dropped.clear ( );
+} // G3Cache::flush
+
+/*!
+ * const QString G3Cache::toPrintout ( ) const
+ * @brief Human readable representation of a cache
+ * @return string description of the cache
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+const QString G3Cache::toPrintout ( ) const
+{
+  return QString("G3Cache [%1 records, %2 pending] (%3)").arg(m->count).arg(m->pending.count()).arg(m->filename);
+} // G3Cache::toPrintout
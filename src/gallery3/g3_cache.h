@@ -0,0 +1,111 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * Defines class G3Cache
+ * A cache keeps the descriptions of items retrieved from a remote Gallery3
+ * system on disk, so they survive the end of the slave process.
+ * @see G3Cache
+ * @author Christian Reiner
+ */
+
+#ifndef G3_CACHE_H
+#define G3_CACHE_H
+
+#include <QFile>
+#include <QMap>
+#include <QSet>
+#include <QVector>
+#include <QVariant>
+#include <KUrl>
+#include "utility/defines.h"
+
+namespace KIO
+{
+  namespace Gallery3
+  {
+    class G3CacheClient;
+
+    /*!
+     * @class G3Cache
+     * @brief Persistent cache of item descriptions of a remote Gallery3 system
+     * Each backend has its own cache file, named after its base url and the
+     * user logged in, inside the local kde cache folder. The file is memory
+     * mapped when read, entries are located by a binary search in a sorted
+     * index, so only the records actually requested are decoded. Records
+     * written are kept in memory and merged into a fresh file when the cache is
+     * flushed, which happens when the slave is idle or when the cache is
+     * destroyed.
+     * File layout (all numbers big endian, quint32):
+     * - header:  magic, version, number of records
+     * - index:   one entry per record, sorted by item id:
+     *            id, offset, length, time fetched, time updated (remotely)
+     * - records: the items attributes, serialized by a QDataStream
+     * Records are handed out without consulting the remote system until they
+     * pass their 'time to live', changes made remotely meanwhile are not noticed
+     * before. Older records are not handed out, the item has to be retrieved
+     * again, which replaces its record.
+     * A shared cache additionally exchanges records with the cache service, so
+     * concurrent slaves profit from items retrieved by each other.
+     * @author Christian Reiner
+     */
+    class G3Cache
+    {
+      public:
+        enum { MAGIC=0x47334943, VERSION=1, HEADER_SIZE=12, INDEX_SIZE=20 };
+        struct Record
+        {
+          quint32    fetched; // time the record was retrieved from the remote system
+          quint32    updated; // time the item was updated inside the remote system
+          QByteArray blob;    // serialized attributes
+        }; // struct Record
+      private:
+        class Members
+        {
+          public:
+            inline Members ( uint ttl, bool shared ) : ttl(ttl), shared(shared), service(NULL), map(NULL), count(0), attempted(FALSE) { }
+            QString              url;      // base url without any credentials
+            QString              user;     // user logged in, empty for anonymous access
+            QString              gallery;  // key identifying the gallery and user
+            QString              filename;
+            const uint           ttl;      // time to live of records in seconds
+            const bool           shared;   // exchange records with the cache service
+            G3CacheClient*       service;  // cache shared with concurrent slaves
+            QFile                file;
+            uchar*               map;      // memory mapped cache file
+            quint32              count;    // number of records inside the mapped file
+            bool                 attempted; // an attempt to map the cache file has been made, kept by close()
+            QMap<g3index,Record> pending;  // records written but not yet flushed
+            QSet<g3index>        dropped;  // records to be removed when flushing
+        }; // class Members
+        Members* const m;
+      protected:
+        void   bind     ( const QString& user );
+        bool   open     ( );
+        void   close    ( );
+        int    find     ( g3index id );
+        bool   record   ( g3index id, Record& record );
+        Record recordAt ( int pos, bool deep=FALSE ) const;
+      public:
+        G3Cache ( const KUrl& baseUrl, const QString& user, uint ttl=ITEM_CACHE_TTL, bool shared=TRUE );
+        ~G3Cache ( );
+        bool          lookup     ( g3index id, QVariantMap& attributes, uint* fetched=NULL, bool shared=TRUE );
+        int           prefetch   ( const QVector<g3index>& ids );
+        void          store      ( g3index id, const QVariantMap& attributes );
+        void          drop       ( g3index id );
+        void          flush      ( );
+        void          setUser    ( const QString& user );
+        inline bool   isDirty    ( ) const { return ! ( m->pending.isEmpty() && m->dropped.isEmpty() ); }
+        const QString toPrintout ( ) const;
+    }; // class G3Cache
+
+  } // namespace Gallery3
+} // namespace KIO
+
+#endif // G3_CACHE_H
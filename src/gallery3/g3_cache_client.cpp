@@ -0,0 +1,241 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * @brief Implements the methods of class G3CacheClient
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+
+#include <QDataStream>
+#include <QProcess>
+#include <kdebug.h>
+#include <kstandarddirs.h>
+#include "gallery3/g3_cache_client.h"
+
+using namespace KIO;
+using namespace KIO::Gallery3;
+
+/*!
+ * QString G3CacheClient::serviceName ( )
+ * @brief Name of the local socket the cache service listens on
+ * @return path of the socket inside the users private socket folder
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+QString G3CacheClient::serviceName ( )
+{
+  return KStandardDirs::locateLocal ( "socket", QLatin1String("kio_gallery3_cached") );
+} // G3CacheClient::serviceName
+
+/*!
+ * G3CacheClient::G3CacheClient ( const QString& gallery )
+ * @brief Constructor
+ * @param gallery key identifying the gallery inside the cache service
+ * The connection to the service is established when it is used first.
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+G3CacheClient::G3CacheClient ( const QString& gallery )
+  : m ( new G3CacheClient::Members(gallery) )
+{
+  kDebug() << "(<gallery>)" << gallery;
+} // G3CacheClient::G3CacheClient
+
+/*!
+ * G3CacheClient::~G3CacheClient ( )
+ * @brief Destructor
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+G3CacheClient::~G3CacheClient ( )
+{
+  kDebug() << "(<>)";
+  m->socket.abort ( );
+  // delete private members
+  delete m;
+} // G3CacheClient::~G3CacheClient
+
+//==========
+
+/*!
+ * bool G3CacheClient::connect ( )
+ * @brief Connects to the cache service
+ * @return TRUE if the service is connected, FALSE otherwise
+ * In case the service cannot be reached it is started in the background,
+ * so that slaves started later can use it.
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+bool G3CacheClient::connect ( )
+{
+  if ( QLocalSocket::ConnectedState==m->socket.state() )
+    return TRUE;
+  if ( ! m->available )
+    return FALSE;
+  m->socket.connectToServer ( serviceName() );
+  if ( m->socket.waitForConnected(ITEM_CACHE_SERVICE_TIMEOUT) )
+  {
+    kDebug() << "connected to cache service";
+    return TRUE;
+  }
+  kDebug() << "cache service not available:" << m->socket.errorString();
+  QString executable = KStandardDirs::findExe ( QLatin1String("kio_gallery3_cached") );
+  if ( ! executable.isEmpty() )
+  {
+    kDebug() << "starting cache service" << executable;
+    QProcess::startDetached ( executable );
+  }
+  fail ( );
+  return FALSE;
+} // G3CacheClient::connect
+
+/*!
+ * void G3CacheClient::fail ( )
+ * @brief Stops using the cache service
+ * The slave continues with its own cache only.
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+void G3CacheClient::fail ( )
+{
+  kDebug() << "(<>)";
+  m->socket.abort ( );
+  m->available = FALSE;
+} // G3CacheClient::fail
+
+/*!
+ * bool G3CacheClient::send ( const QByteArray& message )
+ * @brief Sends a message to the cache service
+ * @param  message the serialized message
+ * @return         TRUE if the message has been sent, FALSE otherwise
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+bool G3CacheClient::send ( const QByteArray& message )
+{
+  if ( ! connect() )
+    return FALSE;
+  QByteArray frame;
+  QDataStream stream ( &frame, QIODevice::WriteOnly );
+  stream << message;
+  m->socket.write ( frame );
+  while ( 0<m->socket.bytesToWrite() )
+    if ( ! m->socket.waitForBytesWritten(ITEM_CACHE_SERVICE_TIMEOUT) )
+    {
+      kDebug() << "failed to send message to cache service:" << m->socket.errorString();
+      fail ( );
+      return FALSE;
+    }
+  return TRUE;
+} // G3CacheClient::send
+
+/*!
+ * bool G3CacheClient::receive ( QByteArray& message )
+ * @brief Receives a message from the cache service
+ * @param  message the serialized message
+ * @return         TRUE if a complete message has been received, FALSE otherwise
+ * Messages are prefixed by their length, so we wait until both have arrived.
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+bool G3CacheClient::receive ( QByteArray& message )
+{
+  quint32 size;
+  QDataStream stream ( &m->socket );
+  while ( qint64(sizeof(quint32))>m->socket.bytesAvailable() )
+    if ( ! m->socket.waitForReadyRead(ITEM_CACHE_SERVICE_TIMEOUT) )
+    {
+      kDebug() << "no reply from cache service:" << m->socket.errorString();
+      fail ( );
+      return FALSE;
+    }
+  stream >> size;
+  while ( qint64(size)>m->socket.bytesAvailable() )
+    if ( ! m->socket.waitForReadyRead(ITEM_CACHE_SERVICE_TIMEOUT) )
+    {
+      kDebug() << "incomplete reply from cache service:" << m->socket.errorString();
+      fail ( );
+      return FALSE;
+    }
+  message = m->socket.read ( size );
+  return TRUE;
+} // G3CacheClient::receive
+
+//==========
+
+/*!
+ * bool G3CacheClient::lookup ( const QVector<g3index>& ids, QHash<g3index,G3Cache::Record>& records )
+ * @brief Asks the cache service for the descriptions of items
+ * @param  ids     numeric ids of the items
+ * @param  records receives the records known to the service, by item id
+ * @return         TRUE if the service has answered, FALSE otherwise
+ * All items are looked up by a single message, so a listing costs a single
+ * round trip to the service.
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+bool G3CacheClient::lookup ( const QVector<g3index>& ids, QHash<g3index,G3Cache::Record>& records )
+{
+  kDebug() << "(<ids[count]>)" << ids.count();
+  QByteArray message;
+  QDataStream request ( &message, QIODevice::WriteOnly );
+  request << quint8(LOOKUP) << m->gallery << ids;
+  if ( ! send(message) )
+    return FALSE;
+  QByteArray answer;
+  if ( ! receive(answer) )
+    return FALSE;
+  QDataStream stream ( answer );
+  quint32 count;
+  stream >> count;
+  for ( quint32 pos=0; pos<count && QDataStream::Ok==stream.status(); pos++ )
+  {
+    quint32         id;
+    G3Cache::Record record;
+    stream >> id >> record.fetched >> record.updated >> record.blob;
+    if ( QDataStream::Ok==stream.status() )
+      records.insert ( id, record );
+  } // for
+  kDebug() << "cache service knows" << records.count() << "items";
+  return ( QDataStream::Ok==stream.status() );
+} // G3CacheClient::lookup
+
+/*!
+ * void G3CacheClient::store ( g3index id, const G3Cache::Record& record )
+ * @brief Hands the description of an item over to the cache service
+ * @param id     numeric item id
+ * @param record the record as stored in the local cache
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+void G3CacheClient::store ( g3index id, const G3Cache::Record& record )
+{
+  kDebug() << "(<id>)" << id;
+  QByteArray message;
+  QDataStream request ( &message, QIODevice::WriteOnly );
+  request << quint8(STORE) << m->gallery << quint32(id) << record.fetched << record.updated << record.blob;
+  send ( message );
+} // G3CacheClient::store
+
+/*!
+ * void G3CacheClient::drop ( g3index id )
+ * @brief Tells the cache service to forget about an item
+ * @param id numeric item id
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+void G3CacheClient::drop ( g3index id )
+{
+  kDebug() << "(<id>)" << id;
+  QByteArray message;
+  QDataStream request ( &message, QIODevice::WriteOnly );
+  request << quint8(DROP) << m->gallery << quint32(id);
+  send ( message );
+} // G3CacheClient::drop
@@ -0,0 +1,83 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * Defines class G3CacheClient
+ * A cache client connects a slave to the cache service shared by all slaves
+ * of the local user.
+ * @see G3CacheClient
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+
+#ifndef G3_CACHE_CLIENT_H
+#define G3_CACHE_CLIENT_H
+
+#include <QHash>
+#include <QLocalSocket>
+#include <QVector>
+#include "utility/defines.h"
+#include "gallery3/g3_cache.h"
+
+namespace KIO
+{
+  namespace Gallery3
+  {
+
+    /*!
+     * @class G3CacheClient
+     * @brief Access to the cache service shared by concurrent slaves
+     * Item descriptions retrieved by one slave are handed over to the cache
+     * service, other slaves ask the service before contacting the remote
+     * Gallery3 system themselves. This way slaves started at the same time (as
+     * it typically happens when a file manager creates previews) share the
+     * effort of retrieving the item hierarchy.
+     * The messages exchanged via a local socket are streamed by a QDataStream,
+     * each one prefixed by its length:
+     * - LOOKUP: gallery, ids                             -> count, count * ( id, fetched, updated, attributes )
+     * - STORE:  gallery, id, fetched, updated, attributes
+     * - DROP:   gallery, id
+     * A lookup asks for any number of items at once, the reply holds the records
+     * of those items the service knows about.
+     * The client is purely optional: if the service cannot be reached it is
+     * started once in the background and ignored for the rest of the session.
+     * @author Christian Reiner
+     */
+    class G3CacheClient
+    {
+      public:
+        enum Command { LOOKUP=1, STORE=2, DROP=3 };
+        static QString serviceName ( );
+      private:
+        class Members
+        {
+          public:
+            inline Members ( const QString& gallery ) : gallery(gallery), available(TRUE) { }
+            const QString gallery;   // key identifying the gallery inside the service
+            QLocalSocket  socket;
+            bool          available; // service has not yet failed
+        }; // class Members
+        Members* const m;
+      protected:
+        bool connect ( );
+        bool send    ( const QByteArray& message );
+        bool receive ( QByteArray& message );
+        void fail    ( );
+      public:
+        G3CacheClient ( const QString& gallery );
+        ~G3CacheClient ( );
+        bool lookup ( const QVector<g3index>& ids, QHash<g3index,G3Cache::Record>& records );
+        void store  ( g3index id, const G3Cache::Record& record );
+        void drop   ( g3index id );
+    }; // class G3CacheClient
+
+  } // namespace Gallery3
+} // namespace KIO
+
+#endif // G3_CACHE_CLIENT_H
@@ -0,0 +1,98 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * Defines class G3Chunking, describing how lists of items are split into
+ * chunks when being retrieved from the remote Gallery3 system.
+ * The class is a 'header only library', no methods are defined in an
+ * additional .cpp file, so no linkage is required.
+ * @see G3Chunking
+ * @author Christian Reiner
+ */
+
+#ifndef G3_CHUNKING_H
+#define G3_CHUNKING_H
+
+#include <QString>
+#include <QtGlobal>
+#include "utility/defines.h"
+
+namespace KIO
+{
+  namespace Gallery3
+  {
+
+    /*!
+     * @class G3Chunking
+     * @brief Policy for batched retrieval of items
+     * Decides about the number of items requested in a single 'items?urls='
+     * request and about the way such a request is sent:
+     * - GET:  the list of urls is part of the request url, chunks are cut
+     *         when the url would grow beyond the configured length
+     * - POST: the request is tunnelled as a http post, the urls are sent as
+     *         form payload, the url length does not matter
+     * - AUTO: GET as long as the url length allows, POST otherwise
+     * In adaptive mode the chunk size grows as long as the server answers
+     * quickly and shrinks when it answers slowly or with an error.
+     * This is a header-only implementation, no source or object file has to be be considered.
+     * @author Christian Reiner
+     */
+    class G3Chunking
+    {
+      public:
+        enum Method { GET, POST, AUTO };
+      private:
+        int    m_size;
+        int    m_maximum;
+        bool   m_adaptive;
+        int    m_responseTime;
+        int    m_urlLength;
+        Method m_method;
+      public:
+        inline G3Chunking ( int size=ITEM_LIST_CHUNK_SIZE, int maximum=ITEM_LIST_CHUNK_SIZE_MAX, bool adaptive=FALSE,
+                            int responseTime=ITEM_LIST_RESPONSE_TIME, int urlLength=ITEM_LIST_URL_LENGTH, Method method=AUTO )
+                          : m_size(qBound(1,size,qMax(1,maximum))), m_maximum(qMax(1,maximum)), m_adaptive(adaptive)
+                          , m_responseTime(responseTime), m_urlLength(urlLength), m_method(method) { }
+        inline int    size         ( ) const { return m_size; }
+        inline int    maximum      ( ) const { return m_maximum; }
+        inline bool   isAdaptive   ( ) const { return m_adaptive; }
+        inline int    responseTime ( ) const { return m_responseTime; }
+        inline int    urlLength    ( ) const { return m_urlLength; }
+        inline Method method       ( ) const { return m_method; }
+        // only complete chunks tell something about the servers limits:
+        // a quick answer doubles the chunk size, a slow one halves it
+        inline void succeeded ( int count, int msecs )
+        {
+          if ( ! m_adaptive || count<m_size )
+            return;
+          if ( msecs<m_responseTime/2 )
+            m_size = qMin ( m_maximum, 2*m_size );
+          else if ( msecs>m_responseTime )
+            m_size = qMax ( 1, m_size/2 );
+        }
+        // the chunk size drops below the size of a chunk the server failed to process
+        inline void failed ( int count )
+        {
+          if ( m_adaptive )
+            m_size = qMax ( 1, qMin(m_size,count)/2 );
+        }
+        static inline Method methodFromString ( const QString& method )
+        {
+          if ( 0==method.compare(QLatin1String("get"),Qt::CaseInsensitive) )
+            return GET;
+          if ( 0==method.compare(QLatin1String("post"),Qt::CaseInsensitive) )
+            return POST;
+          return AUTO;
+        }
+    }; // class G3Chunking
+
+  } // namespace Gallery3
+} // namespace KIO
+
+#endif // G3_CHUNKING_H
@@ -0,0 +1,161 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * Defines class G3ItemTable, the registry of all items known to a backend.
+ * The class is a 'header only library', no methods are defined in an
+ * additional .cpp file, so no linkage is required.
+ * @see G3ItemTable
+ * @author Christian Reiner
+ */
+
+#ifndef G3_ITEM_TABLE_H
+#define G3_ITEM_TABLE_H
+
+#include <QVector>
+#include <QHash>
+#include "utility/defines.h"
+
+namespace KIO
+{
+  namespace Gallery3
+  {
+    class G3Item;
+
+    /*!
+     * @class G3ItemTable
+     * @brief Registry of items indexed by their id
+     * Gallery3 hands out item ids as consecutive numbers, so the items are
+     * stored in a plain vector using the id as index: a lookup is a single
+     * array access and no node has to be allocated per item.
+     * The vector only grows as long as it stays reasonably full, that is it
+     * holds at least one item per ITEM_TABLE_DENSE_FILL slots. Ids beyond it
+     * are kept in a hash instead, so a single huge id cannot blow up the
+     * vector. Items of the hash are moved into the vector when it grows.
+     * The items are iterated in place, nothing is copied.
+     * This is a header-only implementation, no source or object file has to be be considered.
+     * @author Christian Reiner
+     */
+    class G3ItemTable
+    {
+      private:
+        QVector<G3Item*>       m_dense;
+        QHash<g3index,G3Item*> m_sparse;
+        int                    m_count;
+      public:
+        /*!
+         * @class const_iterator
+         * @brief Visits all registered items, the vector first, then the hash
+         * Like with Qt's containers the table must not be modified whilst iterated.
+         */
+        class const_iterator
+        {
+          private:
+            const G3ItemTable*                     m_table;
+            int                                    m_pos;
+            QHash<g3index,G3Item*>::const_iterator m_it;
+            // skip empty slots of the vector
+            inline void settle ( )
+            {
+              while ( m_pos<m_table->m_dense.size() && NULL==m_table->m_dense.at(m_pos) )
+                m_pos++;
+            }
+          public:
+            inline const_iterator ( const G3ItemTable* table, bool end )
+              : m_table(table)
+              , m_pos(end?table->m_dense.size():0)
+              , m_it(end?table->m_sparse.constEnd():table->m_sparse.constBegin()) { settle(); }
+            inline G3Item* operator* ( ) const { return ( m_pos<m_table->m_dense.size() ) ? m_table->m_dense.at(m_pos) : m_it.value(); }
+            inline bool operator== ( const const_iterator& other ) const { return m_pos==other.m_pos && m_it==other.m_it; }
+            inline bool operator!= ( const const_iterator& other ) const { return ! operator==(other); }
+            inline const_iterator& operator++ ( )
+            {
+              if ( m_pos<m_table->m_dense.size() )
+              {
+                m_pos++;
+                settle ( );
+              }
+              else
+                ++m_it;
+              return *this;
+            }
+        }; // class const_iterator
+        friend class const_iterator;
+        inline G3ItemTable ( ) : m_count(0) { }
+        inline int     count    ( ) const { return m_count; }
+        inline bool    isEmpty  ( ) const { return 0==m_count; }
+        inline bool    contains ( g3index id ) const { return NULL!=value(id); }
+        inline const_iterator constBegin ( ) const { return const_iterator ( this, FALSE ); }
+        inline const_iterator constEnd   ( ) const { return const_iterator ( this, TRUE ); }
+        inline G3Item* value    ( g3index id ) const
+        {
+          if ( id<g3index(m_dense.size()) )
+            return m_dense.at ( id );
+          return m_sparse.value ( id, NULL );
+        }
+        inline void insert ( g3index id, G3Item* item )
+        {
+          if ( id>=g3index(m_dense.size()) )
+          {
+            // grow in steps of doubled size to keep the number of reallocations low,
+            // but only as long as the vector stays reasonably full
+            const g3index size  = qMax ( 2*g3index(m_dense.size()), id+1 );
+            const g3index dense = m_count - m_sparse.count() + 1;
+            if ( size>ITEM_TABLE_DENSE_LIMIT || ITEM_TABLE_DENSE_FILL*dense<size )
+            {
+              if ( ! m_sparse.contains(id) )
+                m_count++;
+              m_sparse.insert ( id, item );
+              return;
+            }
+            m_dense.resize ( size );
+            // items of the hash now covered by the vector are moved over
+            QHash<g3index,G3Item*>::iterator it = m_sparse.begin ( );
+            while ( m_sparse.end()!=it )
+              if ( it.key()<size )
+              {
+                m_dense[it.key()] = it.value();
+                it = m_sparse.erase ( it );
+              }
+              else
+                ++it;
+          } // if
+          if ( NULL==m_dense.at(id) )
+            m_count++;
+          m_dense[id] = item;
+        }
+        inline G3Item* take ( g3index id )
+        {
+          G3Item* item = NULL;
+          if ( id<g3index(m_dense.size()) )
+            qSwap ( item, m_dense[id] );
+          else
+            item = m_sparse.take ( id );
+          if ( NULL!=item )
+            m_count--;
+          return item;
+        }
+        // any registered item, NULL if the table is empty
+        inline G3Item* any ( ) const
+        {
+          if ( 0==m_count )
+            return NULL;
+          if ( ! m_sparse.isEmpty() )
+            return m_sparse.constBegin().value();
+          for ( int pos=m_dense.size()-1; pos>=0; pos-- )
+            if ( NULL!=m_dense.at(pos) )
+              return m_dense.at(pos);
+          return NULL;
+        }
+    }; // class G3ItemTable
+
+  } // namespace Gallery3
+} // namespace KIO
+
+#endif // G3_ITEM_TABLE_H
@@ -0,0 +1,239 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * @brief Implements the methods of class G3Multipart
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+
+#include <string.h>
+#include <kdebug.h>
+#include "entity/g3_file.h"
+#include "gallery3/g3_multipart.h"
+
+using namespace KIO;
+using namespace KIO::Gallery3;
+
+/*!
+ * G3Multipart::G3Multipart ( const QHash<QString,QString>& query, const G3File* const file, const QString& boundary, QObject* parent )
+ * @brief Constructor
+ * @param query    set of query items to be sent as separate parts
+ * @param file     internal file description specifying the file to be uploaded
+ * @param boundary marker separating the parts
+ * @param parent   owning object, typically the request the body is sent by
+ * Prepares preamble and epilogue of the body, the file itself is opened
+ * when the device is opened.
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+G3Multipart::G3Multipart ( const QHash<QString,QString>& query, const G3File* const file, const QString& boundary, QObject* parent )
+  : QIODevice ( parent )
+  , m         ( new G3Multipart::Members(file->filepath(),file->device()) )
+{
+  KDebug::Block block ( "G3Multipart::G3Multipart" );
+  kDebug() << "(<query> <file[name]>)" << query.keys() << file->filename();
+  // one part for each query item
+  for ( QHash<QString,QString>::const_iterator it=query.constBegin(); it!=query.constEnd(); it++ )
+  {
+    m->preamble.append ( QString("--%1\r\n").arg(boundary).toAscii() );
+    m->preamble.append ( QString("Content-Disposition: form-data; name=\"%1\"\r\n").arg(it.key()).toUtf8() );
+    m->preamble.append ( QString("Content-Type: text/plain; charset=UTF-8\r\n").toAscii() );
+    m->preamble.append ( QString("Content-Transfer-Encoding: 8bit\r\n\r\n").toAscii() );
+    m->preamble.append ( it.value().toUtf8() );
+    m->preamble.append ( "\r\n" );
+  } // for
+  // the header of the file to be uploaded
+  m->preamble.append ( QString("--%1\r\n").arg(boundary).toAscii() );
+  m->preamble.append ( QString("Content-Disposition: form-data; name=\"file\"; filename=\"%1\"\r\n").arg(file->filename()).toUtf8() );
+  m->preamble.append ( QString("Content-Type: %1\r\n\r\n").arg(file->mimetype()->name()).toAscii() );
+  // the size of a streamed file has to be known in advance
+  if ( file->device() )
+    m->length = file->size ( );
+  // terminating boundary marker (note the trailing "--")
+  m->epilogue.append ( QString("\r\n--%1--\r\n").arg(boundary).toAscii() );
+} // G3Multipart::G3Multipart
+
+/*!
+ * G3Multipart::~G3Multipart ( )
+ * @brief Destructor
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+G3Multipart::~G3Multipart ( )
+{
+  kDebug() << "(<>)";
+  close ( );
+  // delete private members
+  delete m;
+} // G3Multipart::~G3Multipart
+
+//==========
+
+/*!
+ * bool G3Multipart::open ( OpenMode mode )
+ * @brief Opens the body for reading
+ * @param  mode must be a read only mode
+ * @return      TRUE if the file to be uploaded could be opened, FALSE otherwise
+ * A device the file is streamed from has to be opened by the calling scope.
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+bool G3Multipart::open ( OpenMode mode )
+{
+  kDebug() << "(<mode>)" << mode;
+  if ( mode & QIODevice::WriteOnly )
+    return FALSE;
+  if ( &m->file==m->source )
+  {
+    if ( ! m->file.open(QIODevice::ReadOnly) )
+    {
+      setErrorString ( m->file.errorString() );
+      return FALSE;
+    }
+    m->length = m->file.size ( );
+  }
+  else if ( ! m->source->isReadable() )
+  {
+    setErrorString ( QLatin1String("streamed file not readable") );
+    return FALSE;
+  }
+  m->offset = 0;
+  return QIODevice::open ( mode | QIODevice::Unbuffered );
+} // G3Multipart::open
+
+/*!
+ * void G3Multipart::close ( )
+ * @brief Closes the body and the file to be uploaded
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+void G3Multipart::close ( )
+{
+  m->file.close ( );
+  QIODevice::close ( );
+} // G3Multipart::close
+
+/*!
+ * qint64 G3Multipart::size ( ) const
+ * @brief Size of the whole body
+ * @return number of bytes of preamble, file and epilogue
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+qint64 G3Multipart::size ( ) const
+{
+  return m->preamble.size() + m->length + m->epilogue.size();
+} // G3Multipart::size
+
+/*!
+ * bool G3Multipart::seek ( qint64 pos )
+ * @brief Moves the read position inside the body
+ * @param  pos new position
+ * @return     TRUE if the position could be set, FALSE otherwise
+ * Typically used to restart the transfer, for example after an authentication.
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+bool G3Multipart::seek ( qint64 pos )
+{
+  kDebug() << "(<pos>)" << pos;
+  if ( pos<0 || pos>size() )
+    return FALSE;
+  // data already read from a stream is gone
+  if ( m->source->isSequential() )
+  {
+    if ( pos!=m->offset )
+    {
+      kDebug() << "cannot restart a streamed body";
+      return FALSE;
+    }
+  }
+  else if ( ! m->source->seek(qBound(qint64(0),pos-m->preamble.size(),m->length)) )
+    return FALSE;
+  m->offset = pos;
+  return QIODevice::seek ( pos );
+} // G3Multipart::seek
+
+/*!
+ * bool G3Multipart::isRestartable ( ) const
+ * @brief Tells if the body can be sent again
+ * @return TRUE if the file content is still available, FALSE otherwise
+ * A body streamed from a sequential device cannot be sent again once the
+ * content has been read from that device.
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+bool G3Multipart::isRestartable ( ) const
+{
+  return ! m->source->isSequential() || m->offset<=m->preamble.size();
+} // G3Multipart::isRestartable
+
+/*!
+ * qint64 G3Multipart::readData ( char* data, qint64 maxSize )
+ * @brief Provides the next piece of the body
+ * @param  data    buffer to be filled
+ * @param  maxSize size of the buffer
+ * @return         number of bytes provided, -1 in case of an error
+ * Copies from preamble, file and epilogue, whatever the current position
+ * points to. At most UPLOAD_CHUNK_SIZE bytes are provided per call.
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+qint64 G3Multipart::readData ( char* data, qint64 maxSize )
+{
+  maxSize = qMin ( maxSize, qint64(UPLOAD_CHUNK_SIZE) );
+  const qint64 preamble = m->preamble.size ( );
+  qint64 count = 0;
+  while ( count<maxSize && m->offset<size() )
+  {
+    qint64 chunk;
+    if ( m->offset<preamble )
+    {
+      chunk = qMin ( maxSize-count, preamble-m->offset );
+      memcpy ( data+count, m->preamble.constData()+m->offset, chunk );
+    }
+    else if ( m->offset<preamble+m->length )
+    {
+      chunk = m->source->read ( data+count, qMin(maxSize-count,preamble+m->length-m->offset) );
+      if ( 0>=chunk )
+      {
+        kDebug() << "failed to read file to be uploaded:" << m->source->errorString();
+        setErrorString ( m->source->errorString() );
+        return ( 0<count ) ? count : -1;
+      }
+    }
+    else
+    {
+      qint64 pos = m->offset - preamble - m->length;
+      chunk = qMin ( maxSize-count, m->epilogue.size()-pos );
+      memcpy ( data+count, m->epilogue.constData()+pos, chunk );
+    }
+    count     += chunk;
+    m->offset += chunk;
+  } // while
+  emit signalProgress ( qBound(qint64(0),m->offset-preamble,m->length), m->length );
+  return count;
+} // G3Multipart::readData
+
+/*!
+ * qint64 G3Multipart::writeData ( const char* data, qint64 maxSize )
+ * @brief The body is read only
+ * @return always -1
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+qint64 G3Multipart::writeData ( const char* data, qint64 maxSize )
+{
+  Q_UNUSED ( data );
+  Q_UNUSED ( maxSize );
+  return -1;
+} // G3Multipart::writeData
+
+#include "gallery3/g3_multipart.moc"
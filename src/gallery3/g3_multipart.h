@@ -0,0 +1,83 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * Defines class G3Multipart
+ * A multipart form used to upload a file as part of a request, streamed
+ * instead of being assembled in memory.
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+
+#ifndef G3_MULTIPART_H
+#define G3_MULTIPART_H
+
+#include <QIODevice>
+#include <QFile>
+#include <QHash>
+#include "utility/defines.h"
+
+namespace KIO
+{
+  namespace Gallery3
+  {
+    class G3File;
+
+    /*!
+     * @class G3Multipart
+     * @brief Streamed multipart http post body
+     * A read only device presenting a complete 'multipart/form-data' body:
+     * - a preamble holding one part per query item and the header of the file part
+     * - the content of the file to be uploaded, read piece by piece, either from
+     *   a local file or from a device streaming the content
+     * - the terminating boundary marker
+     * Only preamble and epilogue are kept in memory, the file content is read
+     * in pieces of at most UPLOAD_CHUNK_SIZE bytes when the transfer asks
+     * for more data. The signal 'signalProgress' reports the number of bytes
+     * of the file content handed over to the transfer so far.
+     * Note that a body streamed from a sequential device cannot be restarted.
+     * @author Christian Reiner
+     */
+    class G3Multipart
+      : public QIODevice
+    {
+      class Members
+      {
+        public:
+          inline Members ( const QString& filepath, QIODevice* device ) : file(filepath), source(device?device:&file), length(0), offset(0) { }
+          QFile      file;
+          QIODevice* source;   // the file or a device the content is streamed from
+          QByteArray preamble;
+          QByteArray epilogue;
+          qint64     length;   // size of the file as it was opened
+          qint64     offset;   // current read position inside the whole body
+      }; // class Members
+      Q_OBJECT
+      private:
+        Members* const m;
+      protected:
+        qint64 readData  ( char* data, qint64 maxSize );
+        qint64 writeData ( const char* data, qint64 maxSize );
+      public:
+        G3Multipart ( const QHash<QString,QString>& query, const G3File* const file, const QString& boundary, QObject* parent=NULL );
+        ~G3Multipart ( );
+        bool        open         ( OpenMode mode );
+        void        close        ( );
+        bool        seek         ( qint64 pos );
+        qint64      size         ( ) const;
+        inline bool isSequential ( ) const { return FALSE; }
+        bool        isRestartable ( ) const;
+      signals:
+        void signalProgress ( qint64 processed, qint64 total );
+    }; // class G3Multipart
+
+  } // namespace Gallery3
+} // namespace KIO
+
+#endif // G3_MULTIPART_H
@@ -0,0 +1,152 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * @brief Implements the methods of class G3Pipeline
+ * @see G3Pipeline
+ * @author Christian Reiner
+ */
+
+#include <QEventLoop>
+#include <kdebug.h>
+#include "gallery3/g3_pipeline.h"
+#include "gallery3/g3_request.h"
+
+using namespace KIO;
+using namespace KIO::Gallery3;
+
+/*!
+ * G3Pipeline::G3Pipeline ( QObject* parent, int concurrency )
+ * @brief Constructor
+ * @param parent      owning object, typically the backend the pipeline works for
+ * @param concurrency maximum number of requests processed at the same time
+ * @see G3Pipeline
+ * @author Christian Reiner
+ */
+G3Pipeline::G3Pipeline ( QObject* parent, int concurrency )
+  : QObject ( parent )
+  , m       ( new G3Pipeline::Members(qMax(1,concurrency)) )
+{
+  KDebug::Block block ( "G3Pipeline::G3Pipeline" );
+  kDebug() << "(<concurrency>)" << m->concurrency;
+} // G3Pipeline::G3Pipeline
+
+/*!
+ * G3Pipeline::~G3Pipeline ( )
+ * @brief Destructor
+ * Requests still waiting in the queue are simply forgotten, the pipeline
+ * does not own them.
+ * @see G3Pipeline
+ * @author Christian Reiner
+ */
+G3Pipeline::~G3Pipeline ( )
+{
+  KDebug::Block block ( "G3Pipeline::~G3Pipeline" );
+  kDebug() << "(<>)" << m->queue.count() << "queued" << m->active.count() << "active";
+  // delete private members
+  delete m;
+} // G3Pipeline::~G3Pipeline
+
+//==========
+
+/*!
+ * void G3Pipeline::setConcurrency ( int concurrency )
+ * @brief Changes the number of requests processed at the same time
+ * @param concurrency maximum number of requests in flight, at least 1
+ * @see G3Pipeline
+ * @author Christian Reiner
+ */
+void G3Pipeline::setConcurrency ( int concurrency )
+{
+  kDebug() << "(<concurrency>)" << concurrency;
+  m->concurrency = qMax ( 1, concurrency );
+} // G3Pipeline::setConcurrency
+
+/*!
+ * void G3Pipeline::enqueue ( G3Request* request )
+ * @brief Accepts a request for processing
+ * @param request a fully prepared request (query items specified)
+ * The request is queued and started as soon as a slot is available.
+ * Processing only happens whilst an event loop is running, typically inside run().
+ * @see G3Pipeline
+ * @author Christian Reiner
+ */
+void G3Pipeline::enqueue ( G3Request* request )
+{
+  kDebug() << "(<request>)";
+  m->queue.enqueue ( request );
+  dispatch ( );
+} // G3Pipeline::enqueue
+
+/*!
+ * void G3Pipeline::dispatch ( )
+ * @brief Starts queued requests as long as the concurrency limit allows
+ * @see G3Pipeline
+ * @author Christian Reiner
+ */
+void G3Pipeline::dispatch ( )
+{
+  while ( ! m->queue.isEmpty() && m->active.count()<m->concurrency )
+  {
+    G3Request* request = m->queue.dequeue ( );
+    m->active << request;
+    connect ( request, SIGNAL(signalFinished(G3Request*)),
+              this,    SLOT(slotRequestFinished(G3Request*)) );
+    kDebug() << "starting request" << m->active.count() << "of" << m->concurrency << "," << m->queue.count() << "still queued";
+    request->start ( );
+  } // while
+} // G3Pipeline::dispatch
+
+/*!
+ * G3Request* G3Pipeline::next ( )
+ * @brief Processes enqueued requests until the next one has finished
+ * @return the request that has finished, NULL if no request is left
+ * Blocks until one of the requests enqueued has finished and hands it out,
+ * requests that have finished meanwhile are handed out in their order of
+ * completion without blocking. Errors are not thrown but stored inside the
+ * requests, it is up to the calling scope to evaluate them.
+ * @see G3Pipeline
+ * @author Christian Reiner
+ */
+G3Request* G3Pipeline::next ( )
+{
+  kDebug() << "(<>)" << m->queue.count() << "queued" << m->active.count() << "active" << m->finished.count() << "finished";
+  dispatch ( );
+  if ( m->finished.isEmpty() && ! isIdle() )
+  {
+    QEventLoop loop;
+    connect ( this, SIGNAL(signalRequestFinished(G3Request*)), &loop, SLOT(quit()) );
+    loop.exec ( QEventLoop::ExcludeUserInputEvents );
+  }
+  return m->finished.isEmpty() ? NULL : m->finished.dequeue();
+} // G3Pipeline::next
+
+/*!
+ * void G3Pipeline::slotRequestFinished ( G3Request* request )
+ * @brief Book keeping after a request has finished
+ * @param request the request that has just finished, successful or not
+ * Frees the requests slot, announces the request and starts the next one.
+ * The request is remembered until it is handed out by next().
+ * @see G3Pipeline
+ * @author Christian Reiner
+ */
+void G3Pipeline::slotRequestFinished ( G3Request* request )
+{
+  kDebug() << "(<request>)";
+  disconnect ( request, SIGNAL(signalFinished(G3Request*)),
+               this,    SLOT(slotRequestFinished(G3Request*)) );
+  m->active.removeAll ( request );
+  m->finished.enqueue ( request );
+  emit signalRequestFinished ( request );
+  dispatch ( );
+  if ( isIdle() )
+    emit signalIdle ( );
+} // G3Pipeline::slotRequestFinished
+
+#include "gallery3/g3_pipeline.moc"
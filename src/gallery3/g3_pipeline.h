@@ -0,0 +1,80 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * Defines class G3Pipeline
+ * A pipeline keeps several requests against the same remote Gallery3 system
+ * in flight at the same time instead of processing them one after another.
+ * @see G3Pipeline
+ * @author Christian Reiner
+ */
+
+#ifndef G3_PIPELINE_H
+#define G3_PIPELINE_H
+
+#include <QObject>
+#include <QQueue>
+#include <QList>
+#include "utility/defines.h"
+
+namespace KIO
+{
+  namespace Gallery3
+  {
+    class G3Request;
+
+    /*!
+     * @class G3Pipeline
+     * @brief Asynchronous processing of requests against a remote Gallery3 system
+     * Requests are enqueued in the pipeline and started in the background,
+     * at most 'concurrency' of them at the same time. Each finished request is
+     * announced via the signal 'signalRequestFinished', so the calling scope
+     * can evaluate it whilst others are still on their way.
+     * The method next() blocks until the next request has finished, so the
+     * calling scope can process each request as soon as possible without a
+     * slot of its own.
+     * Note that the pipeline does not take ownership of the requests.
+     * @author Christian Reiner
+     */
+    class G3Pipeline
+      : public QObject
+    {
+      class Members
+      {
+        public:
+          inline Members ( int concurrency ) : concurrency(concurrency) { }
+          int                concurrency;
+          QQueue<G3Request*> queue;
+          QList<G3Request*>  active;
+          QQueue<G3Request*> finished; // finished requests not yet handed out by next()
+      }; // class Members
+      Q_OBJECT
+      private:
+        Members* const m;
+      protected:
+        void dispatch ( );
+      public:
+        G3Pipeline ( QObject* parent, int concurrency=REQUEST_CONCURRENCY );
+        ~G3Pipeline ( );
+        inline int  concurrency    ( ) const { return m->concurrency; }
+        inline bool isIdle         ( ) const { return m->queue.isEmpty() && m->active.isEmpty(); }
+        void        setConcurrency ( int concurrency );
+        void        enqueue        ( G3Request* request );
+        G3Request*  next           ( );
+      signals:
+        void signalRequestFinished ( G3Request* request );
+        void signalIdle            ( );
+      private slots:
+        void slotRequestFinished   ( G3Request* request );
+    }; // class G3Pipeline
+
+  } // namespace Gallery3
+} // namespace KIO
+
+#endif // G3_PIPELINE_H
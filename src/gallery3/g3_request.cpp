@@ -16,14 +16,19 @@
 #include <QBuffer>
 #include <QDataStream>
 #include <QByteArray>
+#include <QEventLoop>
+#include <QSet>
+#include <QUrl>
 #include <krandom.h>
 #include <kio/global.h>
 #include <kdeversion.h>
-#include <kio/netaccess.h>
 #include <algorithm>
 #include "utility/exception.h"
 #include "gallery3/g3_request.h"
 #include "gallery3/g3_backend.h"
+#include "gallery3/g3_cache.h"
+#include "gallery3/g3_multipart.h"
+#include "gallery3/g3_pipeline.h"
 #include "entity/g3_file.h"
 #include "entity/g3_item.h"
 
@@ -43,12 +48,17 @@ G3Request::Members::Members ( G3Backend* const backend, KIO::HTTP_METHOD method,
   , method  ( method )
   , service ( service )
   , file    ( file )
-  , payload ( NULL )
   , result  ( QVariant() )
   , meta    ( QMap<QString,QString>() )
   , query   ( QHash<QString,QString>() )
   , status  ( 0 )
   , job     ( NULL )
+  , upload   ( NULL )
+  , tunnel   ( FALSE )
+  , finished ( FALSE )
+  , attempt  ( 0 )
+  , error    ( 0 )
+  , elapsed  ( 0 )
 {
   kDebug();
   requestUrl = backend->restUrl();
@@ -95,6 +105,12 @@ G3Request::G3Request ( G3Backend* const backend, KIO::HTTP_METHOD method, const
 G3Request::~G3Request ( )
 {
   kDebug();
+  // a request dropped whilst still being processed must not leave its job behind
+  if ( ! m->finished && NULL!=m->job )
+  {
+    kDebug() << "killing unfinished background job";
+    m->job->kill ( );
+  }
   // delete private members
   delete m;
 /*
@@ -297,7 +313,8 @@ QByteArray G3Request::webFormPostPayload ( const QHash<QString,QString>& query )
   QStringList queryItems;
   // construct an encoded form payload
   for ( QHash<QString,QString>::const_iterator it=m->query.constBegin(); it!=m->query.constEnd(); it++ )
-    queryItems << QString("%1=%2").arg(it.key()).arg(it.value());
+    queryItems << QString("%1=%2").arg ( QString(QUrl::toPercentEncoding(it.key())),
+                                         QString(QUrl::toPercentEncoding(it.value())) );
   QByteArray buffer;
   buffer = queryItems.join(QLatin1String("&")).toAscii();
   kDebug() << "{<buffer[size]>}" << buffer.size();
@@ -305,46 +322,38 @@ QByteArray G3Request::webFormPostPayload ( const QHash<QString,QString>& query )
 } // G3Request::webFormPostPayload
 
 /*!
- * QByteArray G3Request::webFileFormPostPayload ( const QHash<QString,QString>& query, const G3File* const file )
- * @brief Constructs a multipart http post body holding all query items and a file to be uploaded
- * @param query set of query items to be sent inside the request
- * @param file  internal file description specifying a file to be uploaded during the request
- * @return      http post body
- * Constructs a complete http post body holding multi-part form to be sent to a http server. 
- * This for includes several query items as separate parts and one final file. 
+ * QStringList G3Request::takeChunk ( QStringList& urls, const G3Chunking& chunking, bool& tunnel )
+ * @brief Takes the next chunk from a list of item urls
+ * @param  urls     list of pending item urls, the chunk is removed from it
+ * @param  chunking policy describing size and method of chunks
+ * @param  tunnel   set if the chunk has to be tunnelled as http post
+ * @return          the urls making up the next chunk
+ * Takes up to 'size' urls from the list. When sending the chunk by http get
+ * the chunk is cut as soon as the request url would exceed the configured
+ * length, in 'auto' mode such a chunk is tunnelled as http post instead.
  * @see G3Request
+ * @see G3Chunking
  * @author Christian Reiner
  */
-QByteArray G3Request::webFileFormPostPayload ( const QHash<QString,QString>& query, const G3File* const file )
+QStringList G3Request::takeChunk ( QStringList& urls, const G3Chunking& chunking, bool& tunnel )
 {
-  kDebug() << "(<query> <file[name]>)" << query << ( file ? file->filename() : "-/-" );
-  // write the form data
-  QFile binary ( file->filepath() );
-  binary.open ( QIODevice::ReadOnly );
-  QByteArray buffer;
-  // one part for each query items
-  for ( QHash<QString,QString>::const_iterator it=m->query.constBegin(); it!=m->query.constEnd(); it++ )
+  QStringList chunk;
+  // the items are specified as a json encoded and url encoded list
+  int length = 0;
+  tunnel = ( G3Chunking::POST==chunking.method() );
+  while ( ! urls.isEmpty() && chunk.count()<chunking.size() )
   {
-    buffer.append ( QString("--%1\r\n").arg(m->boundary).toAscii() );
-    buffer.append ( QString("Content-Disposition: form-data; name=\"%1\"\r\n").arg(it.key()).toAscii() );
-    buffer.append ( QString("Content-Type: text/plain; charset=UTF-8\r\n").toAscii() );
-    buffer.append ( QString("Content-Transfer-Encoding: 8bit\r\n\r\n").toAscii() );
-    buffer.append ( it.value().toAscii() );
-  } // for
-  // the file to be uploaded
-  buffer.append ( QString("\r\n--%1\r\n").arg(m->boundary).toAscii() );
-  buffer.append ( QString("Content-Disposition: form-data; name=\"file\"; filename=\"%1\"\r\n").arg(file->filename()).toAscii() );
-//  buffer.append ( QString("Content-Type: application/octet-stream\r\n").toAscii() );
-  buffer.append ( QString("Content-Type: %1\r\n\r\n").arg(file->mimetype()->name()).toAscii() );
-//  buffer.append ( QString("Content-Type: %1\r\n").arg(file->mimetype()->name()).toAscii() );
-//  buffer.append ( QString("Content-Transfer-Encoding: binary\r\n\r\n").toAscii() );
-  buffer.append ( binary.readAll() );
-  // terminating boundary marker (note the trailing "--")
-  buffer.append ( QString("\r\n--%1--").arg(m->boundary).toAscii() );
-  binary.close ( );
-  kDebug() << "{<buffer[size]>}" << buffer.size();
-  return buffer;
-} // G3Request::webFileFormPostPayload
+    length += QUrl::toPercentEncoding(QString("\"%1\",").arg(urls.first())).length();
+    if ( ! chunk.isEmpty() && length>chunking.urlLength() )
+    {
+      if ( G3Chunking::GET==chunking.method() )
+        break;
+      tunnel = TRUE;
+    }
+    chunk << urls.takeFirst ( );
+  } // while
+  return chunk;
+} // G3Request::takeChunk
 
 //==========
 
@@ -363,7 +372,7 @@ void G3Request::setup ( )
   // reset / initialize the members
   m->header.clear();
   m->meta.clear();
-  m->payload = NULL;
+  m->stream.reset ( );
   m->result  = QVariant();
   m->status  = 0;
   // G3 uses 'RemoteAccesKeys' for authentication purposes (see API documentation)
@@ -379,7 +388,14 @@ void G3Request::setup ( )
       addHeaderItem ( QLatin1String("customHTTPHeader"), QLatin1String("X-Gallery-Request-Method: delete") );
       break;
     case KIO::HTTP_GET:
-      m->job = KIO::get ( webUrlWithQueryItems(m->requestUrl,m->query), KIO::Reload, KIO::DefaultFlags );
+      if ( m->tunnel )
+      {
+        // the query is too large for the request url, so we tunnel the request as http post
+        m->job = KIO::http_post ( m->requestUrl, webFormPostPayload(m->query), KIO::DefaultFlags );
+        addHeaderItem ( QLatin1String("content-type"), QLatin1String("Content-Type: application/x-www-form-urlencoded") );
+      }
+      else
+        m->job = KIO::get ( webUrlWithQueryItems(m->requestUrl,m->query), KIO::Reload, KIO::DefaultFlags );
       addHeaderItem ( QLatin1String("customHTTPHeader"), QLatin1String("X-Gallery-Request-Method: get") );
       break;
     case KIO::HTTP_HEAD:
@@ -390,7 +406,14 @@ void G3Request::setup ( )
     case KIO::HTTP_POST:
       if ( m->file )
       {
-        m->job = KIO::http_post ( m->requestUrl, webFileFormPostPayload(m->query,m->file), KIO::DefaultFlags );
+        // the file is streamed as part of a multipart body instead of being read into memory
+        delete m->upload;
+        m->upload = new G3Multipart ( m->query, m->file, m->boundary, this );
+        if ( ! m->upload->open(QIODevice::ReadOnly) )
+          throw Exception ( Error(ERR_CANNOT_OPEN_FOR_READING), m->file->filepath() );
+        connect ( m->upload,           SIGNAL(signalProgress(qint64,qint64)),
+                  m->backend->parent(), SLOT(slotUploadProgress(qint64,qint64)) );
+        m->job = KIO::http_post ( m->requestUrl, m->upload, m->upload->size(), KIO::DefaultFlags );
         addHeaderItem ( QLatin1String("content-type"), QString("Content-Type: multipart/form-data; boundary=%1").arg(m->boundary) );
       }
       else
@@ -414,11 +437,49 @@ void G3Request::setup ( )
   kDebug() << "{<>}";
 } // G3Request::setup
 
+/*!
+ * void G3Request::start ( )
+ * @brief Starts processing a prepared request in the background
+ * Sets up the job if that has not been done before and connects to its
+ * signals. The job itself is started by the kio scheduler as soon as an event
+ * loop is running. The end of processing is announced by the signal
+ * 'signalFinished', errors are stored inside the request and can be raised
+ * later by calling raiseError().
+ * @see G3Request
+ * @author Christian Reiner
+ */
+void G3Request::start ( )
+{
+  KDebug::Block block ( "G3Request::start" );
+  kDebug() << "(<>)";
+  m->finished  = FALSE;
+  m->error     = 0;
+  m->errorText = QString();
+  try
+  {
+    if ( NULL==m->job )
+      setup ( );
+    kDebug() << "sending request to url" << m->job->url();
+    m->stream.reset  ( );
+    m->timer.start   ( );
+    connect ( m->job, SIGNAL(data(KIO::Job*,const QByteArray&)), this, SLOT(slotData(KIO::Job*,const QByteArray&)) );
+    connect ( m->job, SIGNAL(result(KJob*)),                     this, SLOT(slotResult(KJob*)) );
+  }
+  catch ( Exception e )
+  {
+    m->error     = e.getCode();
+    m->errorText = e.getText();
+    m->finished  = TRUE;
+    emit signalFinished ( this );
+  }
+  kDebug() << "{<>}";
+} // G3Request::start
+
 /*!
  * void G3Request::process ( )
  * @brief Processes a prepared request
  * @exception ERR_SLAVE_DEFINED in case of a failure on method level (NOT protocol level)
- * Processes a jbo that has been setup completely before. 
+ * Processes a job that has been setup completely before and waits for its result.
  * Attempts to retry the job after requesting authentication information in case of a http-403 from the server. 
  * @see G3Request
  * @author Christian Reiner
@@ -427,35 +488,107 @@ void G3Request::process ( )
 {
   KDebug::Block block ( "G3Request::process" );
   kDebug() << "(<>)";
-  // prepare handling of authentication info
-  // run the job
-  kDebug() << "sending request to url" << m->job->url();
-  int attempt = 0;
-  do
+  start ( );
+  if ( ! m->finished )
+  {
+    QEventLoop loop;
+    connect ( this, SIGNAL(signalFinished(G3Request*)), &loop, SLOT(quit()) );
+    loop.exec ( QEventLoop::ExcludeUserInputEvents );
+  }
+  raiseError ( );
+  kDebug() << "{<>}"; 
+} // G3Request::process
+
+/*!
+ * void G3Request::raiseError ( )
+ * @brief Raises the error a request has failed with, if any
+ * @exception the exception stored whilst processing the request in the background
+ * Errors cannot be thrown across the event loop that processes a request,
+ * so they are stored and raised afterwards by calling this method.
+ * @see G3Request
+ * @author Christian Reiner
+ */
+void G3Request::raiseError ( )
+{
+  if ( 0!=m->error )
+    throw Exception ( Error(m->error), m->errorText );
+} // G3Request::raiseError
+
+/*!
+ * void G3Request::slotData ( KIO::Job* job, const QByteArray& data )
+ * @brief Decodes the payload as it is delivered by the job
+ * @param job  the job delivering the data
+ * @param data the next portion of the payload
+ * Array elements are decoded as soon as they are complete, the raw payload
+ * is not kept.
+ * @see G3Request
+ * @author Christian Reiner
+ */
+void G3Request::slotData ( KIO::Job* job, const QByteArray& data )
+{
+  Q_UNUSED ( job );
+  m->stream.feed ( data );
+} // G3Request::slotData
+
+/*!
+ * void G3Request::slotResult ( KJob* job )
+ * @brief Evaluates the end of a job on method level
+ * @param job the job that has finished
+ * Stores the meta data and http status of the reply. Restarts the request
+ * after requesting authentication information in case of a http-403 from the
+ * server, unless the request streamed an upload that cannot be sent again.
+ * Otherwise the request is marked as finished and announced via the signal
+ * 'signalFinished'.
+ * Note that jobs delete themselves after having emitted their result.
+ * @see G3Request
+ * @author Christian Reiner
+ */
+void G3Request::slotResult ( KJob* job )
+{
+  KDebug::Block block ( "G3Request::slotResult" );
+  kDebug() << "(<job>)" << job->error();
+  try
   {
-    // if status is 403 this is a retry after a failed attempt
-    // we simply construct a fresh job by calling setup again...
-    //! @todo: required at all ? or can a job simply be run several times ?
-    if ( 403==m->status )
-    {
-      kDebug() << "resetting job for a new trial";
-      setup ( );
-    }
-    if ( ! NetAccess::synchronousRun ( m->job, NULL, &m->payload, &m->finalUrl, &m->meta ) )
-      throw Exception ( Error(ERR_SLAVE_DEFINED),
-                        i18n("request failed: %2 [%1]").arg(m->job->error()).arg(m->job->errorString()) );
     // check for problems on protocol level
-    if ( m->job->error() )
+    if ( job->error() )
       throw Exception ( Error(ERR_SLAVE_DEFINED),
-                        i18n("Runtime error processing job: %2 [%1]").arg(m->job->error()).arg(m->job->errorString()) );
+                        i18n("request failed: %2 [%1]").arg(job->error()).arg(job->errorString()) );
+    m->meta     = m->job->metaData ( );
+    m->finalUrl = m->job->url ( );
+    m->job      = NULL;
+    m->elapsed  = m->timer.elapsed ( );
     // extract and store http status code from reply
     m->status = httpStatusCode();
-  } while (    (m->job->url().fileName()!=QLatin1String("rest")) // exception: g3Check: looking for REST API
-            && (403==m->status)                   // repeat only in this case
-//            && retryWithChangedCredentials(++attempt) );  // retry makes sense if credentials have changed
-            && retryWithChangedCredentials(attempt) );  // retry makes sense if credentials have changed
-  kDebug() << "{<>}"; 
-} // G3Request::process
+    // a streamed upload cannot be sent again, the content is gone
+    if (    (403==m->status)
+         && (NULL!=m->upload)
+         && ! m->upload->isRestartable() )
+      throw Exception ( Error(ERR_ACCESS_DENIED),
+                        i18n("upload of '%1' was refused and cannot be repeated, please authenticate and try again").arg(m->file->filename()) );
+    if (    (m->requestUrl.fileName()!=QLatin1String("rest")) // exception: g3Check: looking for REST API
+         && (403==m->status)                                   // repeat only in this case
+         && m->backend->isInteractive()                        // nobody to ask for credentials otherwise
+         && retryWithChangedCredentials(m->attempt) )          // retry makes sense if credentials have changed
+    {
+      // we simply construct a fresh job by calling setup again...
+      kDebug() << "resetting job for a new trial";
+      setup ( );
+      start ( );
+      return;
+    }
+  } // try
+  catch ( Exception e )
+  {
+    m->job       = NULL;
+    m->error     = e.getCode();
+    m->errorText = e.getText();
+  } // catch
+  m->finished = TRUE;
+  kDebug() << "{<>}";
+  emit signalFinished ( this );
+} // G3Request::slotResult
+
+//==========
 
 /*!
  * void G3Request::evaluate ( )
@@ -463,6 +596,7 @@ void G3Request::process ( )
  * @exception ERR_SLAVE_DEFINED in case of unexpected content syntax, that is non-json-encoded content
  * Evaluates the received result payload of a preceding processed job on a generic level. 
  * Provides the json-parsed payload in form of a QVariant. 
+ * The payload has been decoded incrementally whilst it was received. 
  * @see G3Request
  * @author Christian Reiner
  */
@@ -489,22 +623,13 @@ void G3Request::evaluate ( )
   } // switch
   kDebug() << QString ("request processed [ headers size: %2 / payload size: %1]")
                       .arg(m->meta.size())
-                      .arg(m->payload.size());
+                      .arg(m->stream.size());
   if ( QLatin1String("application/json")!=m->meta[QLatin1String("content-type")] )
     throw Exception ( Error(ERR_SLAVE_DEFINED),
                       i18n("unexpected content type in response: %1").arg(m->meta[QLatin1String("content-type")]) );
   kDebug() << QString("response has expected content type '%1'").arg(m->meta[QLatin1String("content-type")]);
-  // SUCCESS, convert result content (payload) into a usable object structure
-  // NOTE: there is a bug in the G3 API implementation, it returns 'null' instead of an empty json structure in certain cases (DELETE)
-  if ( "null"==m->payload )
-    // gallery3 sends the literal string 'null' when serializing an empty set or object
-    m->result = QVariant();
-  else if ( '"'==m->payload.trimmed()[0] )
-    // QJson crashes when decoding a simple json encoded string ("string")
-    // workaround: we wrap and dewrap it as a single array element
-    m->result = g3parse(QString("["+m->payload+"]").toUtf8()).toList().first();
-  else
-    m->result = g3parse ( m->payload );
+  // SUCCESS, the result content (payload) has been decoded while it was received
+  m->result = m->stream.finish ( );
   kDebug() << "{<>}";
 } // G3Request::process
 
@@ -547,6 +672,9 @@ G3Item* G3Request::toItem ( QVariant& entry )
                       i18n("gallery response did not hold a valid item description") );
   QVariantMap attributes = entry.toMap();
   G3Item* item = G3Item::instantiate ( m->backend, attributes );
+  // remember the description for later sessions
+  if ( m->backend->cache() )
+    m->backend->cache()->store ( item->id(), attributes );
   kDebug() << "{<item>}" << item->toPrintout();
   return item;
 } // G3Request::toItem
@@ -570,10 +698,13 @@ QList<G3Item*> G3Request::toItems ( )
     throw Exception ( Error(ERR_SLAVE_DEFINED),
                       i18n("gallery response did not hold a valid list of item descriptions") );
   QList<QVariant> entries = m->result.toList();
+  m->result = QVariant ( );
   kDebug() << "result holds" << entries.count() << "entries";
   int i=0;
-  foreach ( QVariant entry, entries )
+  // each entry is released as soon as its item has been constructed
+  while ( ! entries.isEmpty() )
   {
+    QVariant entry = entries.takeFirst ( );
     try
     {
       kDebug() << "extracting entry" << ++i << "from response list";
@@ -583,12 +714,36 @@ QList<G3Item*> G3Request::toItems ( )
     { // swallow exception
       kDebug() << "failed to extract item from gallery response:" << e.getText();
     } // catch
-  } // foreach
+  } // while
   kDebug() << "extracted" << items.count() << "items from gallery response";
   kDebug() << "{<items[count]>}" << items.count();
   return items;
 } // G3Request::toItems
 
+/*!
+ * QList<QVariantMap> G3Request::toDescriptions ( )
+ * @brief Extracts the plain item descriptions from a requests reply
+ * @return list of item descriptions
+ * @exception ERR_SLAVE_DEFINED in case the result payload did not hold a list of entries as expected
+ * Entries that are not a valid description are skipped.
+ * @see G3Request
+ * @author Christian Reiner
+ */
+QList<QVariantMap> G3Request::toDescriptions ( )
+{
+  KDebug::Block block ( "G3Request::toDescriptions" );
+  if ( ! m->result.canConvert(QVariant::List) )
+    throw Exception ( Error(ERR_SLAVE_DEFINED),
+                      i18n("gallery response did not hold a valid list of item descriptions") );
+  QList<QVariantMap> descriptions;
+  foreach ( const QVariant& entry, m->result.toList() )
+    if ( entry.canConvert(QVariant::Map) )
+      descriptions << entry.toMap();
+  m->result = QVariant ( );
+  kDebug() << "{<descriptions[count]>}" << descriptions.count();
+  return descriptions;
+} // G3Request::toDescriptions
+
 /*!
  * g3index G3Request::toItemId ( QVariant& entry )
  * @brief Converts a requests reply into a numeric item id
@@ -613,10 +768,10 @@ g3index G3Request::toItemId ( QVariant& entry )
   {
     QMap<QString,QVariant> entity = attributes["entity"].toMap();
     if (    entity.contains("id")
-         && entity[QLatin1String("id")].canConvert(QVariant::Int) )
+         && entity[QLatin1String("id")].canConvert(QVariant::UInt) )
     {
-      kDebug() << "{<id>}" << entity["id"].toInt();
-      return entity[QLatin1String("id")].toInt();
+      kDebug() << "{<id>}" << entity["id"].toUInt();
+      return entity[QLatin1String("id")].toUInt();
     }
     else
       throw Exception ( Error(ERR_INTERNAL), i18n("gallery response did not hold a valid item description") );
@@ -750,6 +905,112 @@ bool G3Request::g3Login ( G3Backend* const backend, AuthInfo& credentials )
   return TRUE;
 } // G3Request::g3Login
 
+/*!
+ * QList<G3Item*> G3Request::getChunked ( G3Backend* const backend, const QStringList& urls, G3Type type, QList<QVariantMap>* descriptions )
+ * @brief Retrieves a list of specified items in chunks processed in parallel
+ * @param backend      backend used for this request
+ * @param urls         list of rest urls pointing to the requested items
+ * @param type         filters result to items of a specific type if specified
+ * @param descriptions collects the plain descriptions instead of constructing items, if specified
+ * @return             list of pointers to valid local item objects
+ * A chunk refused because of its size, that is by a http status 413, 414 or
+ * 5xx, is requested again in smaller chunks once the other chunks have been
+ * processed. Any other failure is raised.
+ * Note that the chunks are evaluated in their order of completion, so the
+ * items are not returned in the order of the urls.
+ * @see G3Request
+ * @author Christian Reiner
+ */
+QList<G3Item*> G3Request::getChunked ( G3Backend* const backend, const QStringList& urls, G3Type type, QList<QVariantMap>* descriptions )
+{
+  G3Chunking& chunking = backend->chunking ( );
+  QList<G3Item*> items;
+  QStringList    pending = urls;
+  while ( ! pending.isEmpty() )
+  {
+    // chunks refused by the server, keyed by their position
+    QMap<int,QStringList> failed;
+    // one request per chunk, all of them handed over to the pipeline at once
+    QList<G3Request*>  requests;
+    QList<QStringList> chunks;
+    while ( ! pending.isEmpty() )
+    {
+      bool tunnel;
+      QStringList urls_chunk = takeChunk ( pending, chunking, tunnel );
+      kDebug() << QString("queueing chunk %1 (%2 items%3)").arg(chunks.count()+1).arg(urls_chunk.count())
+                                                           .arg(tunnel?QLatin1String(", tunnelled"):QLatin1String(""));
+      G3Request* request = new G3Request ( backend, KIO::HTTP_GET, QLatin1String("items") );
+      request->addQueryItem ( QLatin1String("urls"), urls_chunk );
+      request->addQueryItem ( QLatin1String("type"), type );
+      request->setTunnel    ( tunnel );
+      requests << request;
+      chunks   << urls_chunk;
+      backend->pipeline()->enqueue ( request );
+    } // while
+    // evaluate each chunk as soon as it has arrived, whilst the others are still on their way
+    G3Request* request;
+    try
+    {
+      while ( NULL!=(request=backend->pipeline()->next()) )
+      {
+        int i = requests.indexOf ( request );
+        // requests enqueued by another scope are none of our business
+        if ( -1==i )
+          continue;
+        try
+        {
+          request->raiseError ( );
+          request->evaluate   ( );
+        }
+        catch ( Exception e )
+        {
+          // the server might have refused a chunk because of its size: retry smaller ones
+          // transport failures and any other http status are no matter of the chunk size
+          const int status = request->m->status;
+          if (    chunking.isAdaptive()
+               && 1<chunks[i].count()
+               && ( 413==status || 414==status || (500<=status && 600>status) ) )
+          {
+            kDebug() << "chunk of" << chunks[i].count() << "items failed with http status" << status << ", retrying in smaller chunks";
+            chunking.failed ( chunks[i].count() );
+            failed.insert ( i, chunks[i] );
+            continue;
+          }
+          throw e;
+        }
+        chunking.succeeded ( chunks[i].count(), request->elapsed() );
+        if ( NULL!=descriptions )
+          *descriptions << request->toDescriptions ( );
+        else
+        {
+          QList<G3Item*> chunk_items = request->toItems ( );
+          items << chunk_items;
+          // members being listed are handed over chunk by chunk, not after the last chunk
+          QSet<G3Item*> parents;
+          foreach ( G3Item* item, chunk_items )
+            if ( NULL!=item->parent() )
+              parents.insert ( item->parent() );
+          foreach ( G3Item* parent, parents )
+            parent->flushMembers ( );
+        }
+      } // while
+    } // try
+    catch ( Exception e )
+    {
+      // requests still in flight must not be deleted
+      while ( NULL!=backend->pipeline()->next() ) ;
+      qDeleteAll ( requests );
+      throw e;
+    } // catch
+    qDeleteAll ( requests );
+    // failed chunks are requested again, in the order they were queued in
+    foreach ( const QStringList& chunk, failed )
+      pending << chunk;
+    kDebug() << "chunk size now" << chunking.size();
+  } // while
+  return items;
+} // G3Request::getChunked
+
 /*!
  * QList<G3Item*> G3Request::g3GetItems ( G3Backend* const backend, const QStringList& urls, G3Type type )
  * @brief Retrieves a list of specified items from a remote Gallery3 system
@@ -764,27 +1025,32 @@ QList<G3Item*> G3Request::g3GetItems ( G3Backend* const backend, const QStringLi
 {
   KDebug::Block block ( "G3Request::g3GetItems" );
   kDebug() << "(<backend> <urls [count]> <type>)" << backend->toPrintout() << urls.count() << type.toString();
-  QList<G3Item*> items;
-  QStringList urls_chunk;
-  int chunk=0;
-  do
-  {
-    urls_chunk = urls.mid ( (chunk*ITEM_LIST_CHUNK_SIZE), ITEM_LIST_CHUNK_SIZE );
-    kDebug() << QString("retrieving chunk %1 (items %2-%3)").arg(chunk+1).arg(chunk*ITEM_LIST_CHUNK_SIZE)
-//                                                           .arg(MIN((((chunk+1)*ITEM_LIST_CHUNK_SIZE)-1),(urls.count()-1)));
-                                                           .arg(std::min((((chunk+1)*ITEM_LIST_CHUNK_SIZE)-1),(urls.count()-1)));
-    G3Request request ( backend, KIO::HTTP_GET, QLatin1String("items") );
-    request.addQueryItem ( QLatin1String("urls"), urls_chunk );
-    request.addQueryItem ( QLatin1String("type"), type );
-    request.setup        ( );
-    request.process      ( );
-    request.evaluate     ( );
-    items << request.toItems ( );
-  } while ( (++chunk*ITEM_LIST_CHUNK_SIZE)<urls.count() );
+  QList<G3Item*> items = getChunked ( backend, urls, type, NULL );
   kDebug() << "{<items [count]>}" << items.count();
   return items;
 } // G3Request::g3GetItems
 
+/*!
+ * QList<QVariantMap> G3Request::g3GetDescriptions ( G3Backend* const backend, const QStringList& urls )
+ * @brief Retrieves the descriptions of specified items from a remote Gallery3 system
+ * @param backend backend used for this request
+ * @param urls    list of rest urls pointing to the requested items
+ * @return        list of item descriptions, items that do not exist anymore are missing
+ * Like g3GetItems(), but no items are constructed. Used to revalidate items
+ * that exist locally already.
+ * @see G3Request
+ * @author Christian Reiner
+ */
+QList<QVariantMap> G3Request::g3GetDescriptions ( G3Backend* const backend, const QStringList& urls )
+{
+  KDebug::Block block ( "G3Request::g3GetDescriptions" );
+  kDebug() << "(<backend> <urls [count]>)" << backend->toPrintout() << urls.count();
+  QList<QVariantMap> descriptions;
+  getChunked ( backend, urls, G3Type::NONE, &descriptions );
+  kDebug() << "{<descriptions [count]>}" << descriptions.count();
+  return descriptions;
+} // G3Request::g3GetDescriptions
+
 /*!
  * QList<G3Item*> G3Request::g3GetItems ( G3Backend* const backend, g3index id, G3Type type )
  * @brief Retrieves a list of items being members of a given item from a remote Gallery3 system
@@ -830,6 +1096,48 @@ QList<g3index> G3Request::g3GetAncestors ( G3Backend* const backend, G3Item* ite
   return list;
 } // G3Request::g3GetAncestors
 
+/*!
+ * G3Item* G3Request::g3GetAncestry ( G3Backend* const backend, g3index id )
+ * @brief Retrieves an item together with all its ancestors not yet known
+ * @param  backend backend used for this request
+ * @param  id      numeric item id
+ * @return         internal item object of the requested item
+ * A single 'ancestors_for' request returns the complete descriptions of all
+ * items along the path from the base item down to the requested item. These
+ * are constructed top-down, so each item finds its parent registered
+ * already instead of retrieving it by a separate request.
+ * @see G3Request
+ * @author Christian Reiner
+ */
+G3Item* G3Request::g3GetAncestry ( G3Backend* const backend, g3index id )
+{
+  KDebug::Block block ( "G3Request::g3GetAncestry" );
+  kDebug() << "(<backend> <id>)" << backend->toPrintout() << id;
+  G3Request request ( backend, KIO::HTTP_GET, QLatin1String("items") );
+  request.addQueryItem ( QLatin1String("ancestors_for"), QString("%1/item/%2").arg(backend->restUrl().url(KUrl::RemoveTrailingSlash)).arg(id) );
+  request.setup        ( );
+  request.process      ( );
+  request.evaluate     ( );
+  if ( ! request.m->result.canConvert(QVariant::List) )
+    throw Exception ( Error(ERR_SLAVE_DEFINED),
+                      i18n("gallery response did not hold a valid list of item descriptions") );
+  QVariantList entries = request.m->result.toList();
+  request.m->result = QVariant ( );
+  // the ancestors are listed starting at the base item
+  G3Item* item = NULL;
+  while ( ! entries.isEmpty() )
+  {
+    QVariant entry = entries.takeFirst ( );
+    item = backend->items().value ( request.toItemId(entry) );
+    if ( NULL==item )
+      item = request.toItem ( entry );
+  } // while
+  if ( NULL==item || id!=item->id() )
+    throw Exception ( Error(ERR_DOES_NOT_EXIST), i18n("item with id '%1'").arg(id) );
+  kDebug() << "{<item>}" << item->toPrintout();
+  return item;
+} // G3Request::g3GetAncestry
+
 /*!
  * g3index G3Request::g3GetAncestors ( G3Backend* const backend, G3Item* item )
  * @brief Retrieves the path of anchestors of a specified item from a remote Gallery3 system
@@ -862,6 +1170,45 @@ g3index G3Request::g3GetAncestor ( G3Backend* const backend, G3Item* item )
   } // switch
 } // G3Request::g3GetAncestor
 
+/*!
+ * QStringList G3Request::g3GetMemberUrls ( G3Backend* const backend, g3index id, const QString& name, int start, int num )
+ * @brief Retrieves the urls of the members of an item
+ * @param   backend backend used for this request
+ * @param   id      numeric item id of the parent item (album)
+ * @param   name    name of the requested member, all members if empty
+ * @param   start   position of the first member requested
+ * @param   num     maximum number of members requested, all if 0 (zero)
+ * @returns         list of rest urls of the matching members, empty if there is no such member
+ * Asks for the description of the parent item with the list of members
+ * filtered by name or limited to a window. In contrast to g3GetItem() no item
+ * object is constructed, the parent item typically exists already. This way
+ * a single member can be resolved without retrieving all its siblings and a
+ * huge album can be listed page by page.
+ * @see G3Request
+ * @author Christian Reiner
+ */
+QStringList G3Request::g3GetMemberUrls ( G3Backend* const backend, g3index id, const QString& name, int start, int num )
+{
+  KDebug::Block block ( "G3Request::g3GetMemberUrls" );
+  kDebug() << "(<backend> <id> <name> <start> <num>)" << backend->toPrintout() << id << name << start << num;
+  G3Request request ( backend, KIO::HTTP_GET, QString("item/%1").arg(id) );
+  request.addQueryItem ( "scope", QLatin1String("direct") );
+  request.addQueryItem ( "name",  name, TRUE );
+  if ( 0<num )
+  {
+    request.addQueryItem ( "start", QString::number(start) );
+    request.addQueryItem ( "num",   QString::number(num) );
+  }
+  request.setup        ( );
+  request.process      ( );
+  request.evaluate     ( );
+  QStringList urls;
+  foreach ( const QVariant& url, request.m->result.toMap().value(QLatin1String("members")).toList() )
+    urls << url.toString();
+  kDebug() << "{<urls>}" << urls;
+  return urls;
+} // G3Request::g3GetMemberUrls
+
 /*!
  * G3Item* G3Request::g3GetItem ( G3Backend* const backend, g3index id, const QString& scope, const QString& name, bool random, G3Type type )
  * @brief Retrieves a single item specified by its numerical id
@@ -895,17 +1242,46 @@ G3Item* G3Request::g3GetItem ( G3Backend* const backend, g3index id, const QStri
 } // G3Request::g3GetItem
 
 /*!
- * void G3Request::g3PostItem ( G3Backend* const backend, g3index id, const QHash<QString,QString>& attributes, const G3File* file )
+ * bool G3Request::g3ExistsItem ( G3Backend* const backend, g3index id )
+ * @brief Checks if an item exists inside the remote Gallery3 system
+ * @param  backend backend used for this request
+ * @param  id      numeric item id
+ * @return         FALSE if the remote system answers 'not found', TRUE otherwise
+ * Any other error is raised as exception, so an item is never considered
+ * gone without a definite answer.
+ * @see G3Request
+ * @author Christian Reiner
+ */
+bool G3Request::g3ExistsItem ( G3Backend* const backend, g3index id )
+{
+  KDebug::Block block ( "G3Request::g3ExistsItem" );
+  kDebug() << "(<backend> <id>)" << backend->toPrintout() << id;
+  G3Request request ( backend, KIO::HTTP_GET, QString("item/%1").arg(id) );
+  request.setup   ( );
+  request.process ( );
+  if ( 404==request.m->status )
+  {
+    kDebug() << "{<exists>}" << "FALSE";
+    return FALSE;
+  }
+  request.evaluate ( );
+  kDebug() << "{<exists>}" << "TRUE";
+  return TRUE;
+} // G3Request::g3ExistsItem
+
+/*!
+ * QString G3Request::g3PostItem ( G3Backend* const backend, g3index id, const QHash<QString,QString>& attributes, const G3File* file )
  * @brief Creates a new item inside the remote Gallery3 system
- * @param backend    backend used for this request
- * @param id         numeric item id
- * @param attributes list of item attributes to be changed
- * @param file       file to be uploaded as item
+ * @param  backend    backend used for this request
+ * @param  id         numeric item id
+ * @param  attributes list of item attributes to be changed
+ * @param  file       file to be uploaded as item
+ * @return            rest url of the created item
  * Creates a single item described by a list of attributes and a file uploaded as altered content in case of a photo or movie item. 
  * @see G3Request
  * @author Christian Reiner
  */
-void G3Request::g3PostItem ( G3Backend* const backend, g3index id, const QHash<QString,QString>& attributes, const G3File* file )
+QString G3Request::g3PostItem ( G3Backend* const backend, g3index id, const QHash<QString,QString>& attributes, const G3File* file )
 {
   KDebug::Block block ( "G3Request::g3PostItem" );
   kDebug() << "(<backend> <id> <attributes[count]> <file>)" << backend->toPrintout() << id << attributes.count()
@@ -920,6 +1296,13 @@ void G3Request::g3PostItem ( G3Backend* const backend, g3index id, const QHash<Q
   request.setup        ( );
   request.process      ( );
   request.evaluate     ( );
+  // the reply holds the url of the created item
+  QString url = request.m->result.toMap().value(QLatin1String("url")).toString();
+  if ( url.isEmpty() )
+    throw Exception ( Error(ERR_SLAVE_DEFINED),
+                      i18n("gallery response did not hold the url of the created item") );
+  kDebug() << "{<url>}" << url;
+  return url;
 } // G3Request::g3PostItem
 
 /*!
@@ -24,6 +24,7 @@
 #include <QHash>
 #include <QVariant>
 #include <QBuffer>
+#include <QTime>
 #include <KUrl>
 #include <KTemporaryFile>
 #include <kio/http.h>
@@ -32,6 +33,7 @@
 #include "utility/defines.h"
 #include "json/g3_json.h"
 #include "entity/g3_type.h"
+#include "gallery3/g3_chunking.h"
 #include <kio/slavebase.h>
 
 namespace KIO
@@ -41,6 +43,7 @@ namespace KIO
     class G3Backend;
     class G3Item;
     class G3File;
+    class G3Multipart;
 
     /*!
      * @class G3Request
@@ -54,6 +57,10 @@ namespace KIO
      * towards the end of the class definition. These offer better usability
      * in form of a function-call-interface.
      * Use one of the statical methods to generate am object of this class.
+     * Requests are processed asynchronously: start() hands the job over to
+     * the kio scheduler and the signal 'signalFinished' announces its end.
+     * process() simply waits for that, a G3Pipeline keeps several requests in
+     * flight at the same time.
      * @author Christian Reiner
      */
     class G3Request
@@ -77,19 +84,30 @@ namespace KIO
           QHash<QString,QString> header;   // request header items
           QHash<QString,QString> query;    // request query items
           QString                boundary; // multi-part boundary
+          G3Multipart*           upload;   // streamed multi-part body
+          bool                   tunnel;   // send a get request as http post
           // to be received
           int                    status;   // http status code
           QMap<QString,QString>  meta;     // result meta data
-          QByteArray             payload;  // result payload
+          G3JsonStream           stream;   // result payload, decoded while it is received
           QVariant               result;
+          // processing state
+          bool                   finished; // request processed, successful or not
+          int                    attempt;  // authentication attempts
+          int                    error;    // error code of a failed request
+          QString                errorText;
+          QTime                  timer;    // measures the response time
+          int                    elapsed;  // response time in milliseconds
       }; // struct Members
+      friend class G3Pipeline;
       Q_OBJECT
       private:
         Members* const m;
       private:
         KUrl       webUrlWithQueryItems   ( KUrl url, const QHash<QString,QString>& query );
         QByteArray webFormPostPayload     ( const QHash<QString,QString>& query );
-        QByteArray webFileFormPostPayload ( const QHash<QString,QString>& query, const G3File* const file );
+        static QStringList takeChunk      ( QStringList& urls, const G3Chunking& chunking, bool& tunnel );
+        static QList<G3Item*> getChunked  ( G3Backend* const backend, const QStringList& urls, G3Type type, QList<QVariantMap>* descriptions );
       protected:
         G3Request ( G3Backend* const backend, KIO::HTTP_METHOD method, const QString& service=QLatin1String(""), const G3File* const file=NULL );
         ~G3Request ( );
@@ -99,29 +117,42 @@ namespace KIO
         void           addQueryItem   ( const QString& key, const QString& value, bool skipIfEmpty=FALSE );
         void           addQueryItem   ( const QString& key, G3Type value, bool skipIfEmpty=FALSE );
         void           addQueryItem   ( const QString& key, const QStringList& values, bool skipIfEmpty=FALSE );
+        inline void    setTunnel      ( bool tunnel ) { m->tunnel = tunnel; }
+        inline int     elapsed        ( ) const { return m->elapsed; }
         void           setup          ( );
+        void           start          ( );
         void           process        ( );
+        void           raiseError     ( );
         void           evaluate       ( );
         QString        toString       ( );
         G3Item*        toItem         ( QVariant& entry );
         QList<G3Item*> toItems        ( );
+        QList<QVariantMap> toDescriptions ( );
         g3index        toItemId       ( QVariant& entry );
         QList<g3index> toItemIds      ( );
         inline G3Item* toItem         ( ) { return toItem(m->result); }
         inline g3index toItemId       ( ) { return toItemId(m->result); }
       signals:
+        void signalFinished        ( G3Request* request );
         void signalRequestAuthInfo ( G3Backend* backend, AuthInfo& credentials, int attempt );
         void signalMessageBox      ( int& result, SlaveBase::MessageBoxType type, const QString &text, const QString &caption=QString(), const QString &buttonYes=i18n("&Yes"), const QString &buttonNo=i18n("&No") );
         void signalMessageBox      ( int& result, const QString &text, SlaveBase::MessageBoxType type, const QString &caption=QString(), const QString &buttonYes=i18n("&Yes"), const QString &buttonNo=i18n("&No"), const QString &dontAskAgainName=QString() );
+      private slots:
+        void slotData              ( KIO::Job* job, const QByteArray& data );
+        void slotResult            ( KJob* job );
       public:
         static bool           g3Check        ( G3Backend* const backend );
         static bool           g3Login        ( G3Backend* const backend, AuthInfo& credentials );
         static QList<G3Item*> g3GetItems     ( G3Backend* const backend, const QStringList& urls, G3Type type=G3Type::NONE );
         static QList<G3Item*> g3GetItems     ( G3Backend* const backend, g3index id, G3Type type=G3Type::NONE );
+        static QList<QVariantMap> g3GetDescriptions ( G3Backend* const backend, const QStringList& urls );
         static QList<g3index> g3GetAncestors ( G3Backend* const backend, G3Item* item );
         static g3index        g3GetAncestor  ( G3Backend* const backend, G3Item* item );
+        static G3Item*        g3GetAncestry  ( G3Backend* const backend, g3index id );
+        static QStringList    g3GetMemberUrls( G3Backend* const backend, g3index id, const QString& name=QString(), int start=0, int num=0 );
+        static bool           g3ExistsItem   ( G3Backend* const backend, g3index id );
         static G3Item*        g3GetItem      ( G3Backend* const backend, g3index id, const QString& scope=QLatin1String("direct"), const QString& name=QLatin1String(""), bool random=FALSE, G3Type type=G3Type::NONE );
-        static void           g3PostItem     ( G3Backend* const backend, g3index id, const QHash<QString,QString>& attributes, const G3File* const file=NULL );
+        static QString        g3PostItem     ( G3Backend* const backend, g3index id, const QHash<QString,QString>& attributes, const G3File* const file=NULL );
         static void           g3PutItem      ( G3Backend* const backend, g3index id, const QHash<QString,QString>& attributes );
         static void           g3DelItem      ( G3Backend* const backend, g3index id );
         static g3index        g3SetItem      ( G3Backend* const backend, g3index id, const QString& name=QLatin1String(""), G3Type type=G3Type::NONE, const QByteArray& file=0 );
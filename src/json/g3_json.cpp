@@ -11,9 +11,11 @@
  * Implements the methods that wrap the functions provided by the QJson library.
  * @see G3JsonParser
  * @see G3JsonSerializer
+ * @see G3JsonStream
  * @author Christian Reiner
  */
 
+#include <kdebug.h>
 #include "json/g3_json.h"
 #include "utility/exception.h"
 
@@ -96,3 +98,203 @@ QByteArray G3JsonSerializer::g3serialize ( const QVariant &variant )
                       QString("serializing data for the request to the remote gallery produced an error") );
   return _result;
 } // G3JsonSerializer::g3serialize
+
+//==========
+
+/*!
+ * G3JsonStream::G3JsonStream ( )
+ * @brief Constructor
+ * @see G3JsonStream
+ * @author Christian Reiner
+ */
+G3JsonStream::G3JsonStream ( )
+{
+  reset ( );
+} // G3JsonStream::G3JsonStream
+
+/*!
+ * void G3JsonStream::reset ( )
+ * @brief Prepares the decoder for a new reply
+ * @see G3JsonStream
+ * @author Christian Reiner
+ */
+void G3JsonStream::reset ( )
+{
+  m_mode   = UNKNOWN;
+  m_depth  = 0;
+  m_string = FALSE;
+  m_escape = FALSE;
+  m_size   = 0;
+  m_buffer.clear   ( );
+  m_elements.clear ( );
+  m_error.clear    ( );
+} // G3JsonStream::reset
+
+/*!
+ * QVariant G3JsonStream::decode ( const QByteArray& json )
+ * @brief Decodes a single complete json value
+ * @param  json json encoded value
+ * @return      decoded value
+ * @exception ERR_SLAVE_DEFINED in case the value cannot be decoded
+ * QJson crashes when decoding a simple json encoded string ("string"),
+ * so such a value is wrapped and dewrapped as a single array element.
+ * @see G3JsonStream
+ * @author Christian Reiner
+ */
+QVariant G3JsonStream::decode ( const QByteArray& json )
+{
+  if ( '"'==json[0] )
+    return m_parser.g3parse(QByteArray("[")+json+"]").toList().first();
+  return m_parser.g3parse ( json );
+} // G3JsonStream::decode
+
+/*!
+ * void G3JsonStream::element ( )
+ * @brief Decodes the element received completely
+ * The raw data of the element is dropped afterwards.
+ * @see G3JsonStream
+ * @author Christian Reiner
+ */
+void G3JsonStream::element ( )
+{
+  QByteArray json = m_buffer.trimmed ( );
+  m_buffer.clear ( );
+  // an empty array does not contain any element
+  if ( json.isEmpty() )
+    return;
+  try
+  {
+    m_elements << decode ( json );
+  }
+  catch ( Exception e )
+  {
+    m_error = e.getText ( );
+  }
+} // G3JsonStream::element
+
+/*!
+ * void G3JsonStream::feed ( const QByteArray& data )
+ * @brief Consumes the next piece of a reply
+ * @param data next piece of data as delivered by the job
+ * Scans the data for the boundaries of the top level array elements. String
+ * literals are tracked, so brackets and commas inside strings do not count.
+ * @see G3JsonStream
+ * @author Christian Reiner
+ */
+void G3JsonStream::feed ( const QByteArray& data )
+{
+  m_size += data.size ( );
+  if ( ! m_error.isEmpty() )
+    return;
+  const char* chars = data.constData ( );
+  const int   count = data.size ( );
+  int start = 0; // begin of the segment not yet appended to the buffer
+  for ( int pos=0; pos<count; pos++ )
+  {
+    const char c = chars[pos];
+    if ( UNKNOWN==m_mode )
+    {
+      // the first significant character decides about the strategy
+      if ( ' '==c || '\t'==c || '\r'==c || '\n'==c )
+        continue;
+      if ( '['==c )
+      {
+        m_mode  = ARRAY;
+        m_depth = 1;
+        start   = pos+1;
+        continue;
+      }
+      m_mode = SCALAR;
+      start  = pos;
+    } // if
+    if ( SCALAR==m_mode )
+      break;
+    if ( 0==m_depth )
+    {
+      // only whitespace may follow the top level array
+      if ( ' '!=c && '\t'!=c && '\r'!=c && '\n'!=c )
+      {
+        m_error = QString("unexpected content after the end of the response");
+        return;
+      }
+      start = pos+1;
+      continue;
+    } // if
+    if ( m_string )
+    {
+      if ( m_escape )
+        m_escape = FALSE;
+      else if ( '\\'==c )
+        m_escape = TRUE;
+      else if ( '"'==c )
+        m_string = FALSE;
+      continue;
+    } // if
+    switch ( c )
+    {
+      case '"':
+        m_string = TRUE;
+        break;
+      case '[':
+      case '{':
+        m_depth++;
+        break;
+      case ']':
+      case '}':
+        if ( 1<m_depth-- )
+          break;
+        // fall through: end of the top level array, the last element is complete
+      case ',':
+        if ( 1<m_depth )
+          break;
+        m_buffer.append ( chars+start, pos-start );
+        start = pos+1;
+        element ( );
+        if ( ! m_error.isEmpty() )
+          return;
+        break;
+    } // switch
+  } // for
+  if ( start<count && ( SCALAR==m_mode || 0<m_depth ) )
+    m_buffer.append ( chars+start, count-start );
+} // G3JsonStream::feed
+
+/*!
+ * QVariant G3JsonStream::finish ( )
+ * @brief Completes the decoding of a reply
+ * @return the decoded reply
+ * @exception ERR_SLAVE_DEFINED in case the reply could not be decoded
+ * Returns the elements of an array decoded so far or decodes a scalar reply.
+ * @see G3JsonStream
+ * @author Christian Reiner
+ */
+QVariant G3JsonStream::finish ( )
+{
+  kDebug() << "(<>)" << m_size << "bytes," << m_elements.count() << "elements";
+  if ( ! m_error.isEmpty() )
+    throw Exception ( Error(ERR_SLAVE_DEFINED),
+                      QString("parsing the response from the remote gallery produced an error: \n%1").arg(m_error) );
+  switch ( m_mode )
+  {
+    case ARRAY:
+    {
+      if ( 0!=m_depth )
+        throw Exception ( Error(ERR_SLAVE_DEFINED),
+                          QString("parsing the response from the remote gallery produced an error: \nincomplete response") );
+      QVariantList elements = m_elements;
+      m_elements.clear ( );
+      return QVariant ( elements );
+    }
+    case SCALAR:
+    {
+      QByteArray json = m_buffer.trimmed ( );
+      m_buffer.clear ( );
+      // NOTE: there is a bug in the G3 API implementation, it returns 'null' instead of an empty json structure in certain cases (DELETE)
+      if ( "null"==json )
+        return QVariant();
+      return decode ( json );
+    }
+    default:
+      return QVariant();
+  } // switch
+} // G3JsonStream::finish
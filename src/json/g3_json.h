@@ -52,6 +52,45 @@ namespace KIO
         QByteArray g3serialize ( const QVariant& variant );
     }; // class KIOGallery3JsonSerializer
 
+    /*!
+     * @class G3JsonStream
+     * @brief Incremental decoder for json encoded replies
+     * Consumes a reply piece by piece as it is delivered by a job. A reply
+     * holding a json array is split into its top level elements while the
+     * data arrives, each element is decoded as soon as it is complete and the
+     * raw data is dropped. So decoding overlaps the transfer and only the
+     * element currently received is kept in raw form.
+     * Any other reply (an object, a string or 'null') is collected and
+     * decoded as a whole when the reply is complete.
+     * Errors cannot be thrown from inside the slot receiving the data, they
+     * are stored and thrown by finish().
+     * @author Christian Reiner
+     */
+    class G3JsonStream
+    {
+      public:
+        enum Mode { UNKNOWN, ARRAY, SCALAR };
+      private:
+        G3JsonParser m_parser;
+        Mode         m_mode;
+        int          m_depth;    // nesting level inside the top level array
+        bool         m_string;   // inside a string literal
+        bool         m_escape;   // last character was an escape character
+        qint64       m_size;     // total number of bytes consumed
+        QByteArray   m_buffer;   // element currently received or the complete scalar reply
+        QVariantList m_elements; // decoded top level elements
+        QString      m_error;
+        void element ( );
+        QVariant decode ( const QByteArray& json );
+      public:
+        G3JsonStream ( );
+        void          reset  ( );
+        void          feed   ( const QByteArray& data );
+        QVariant      finish ( );
+        inline qint64 size   ( ) const { return m_size; }
+        inline int    count  ( ) const { return m_elements.count(); }
+    }; // class G3JsonStream
+
   } // namespace Gallery3
 } // namespace KIO
 
@@ -0,0 +1,37 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * @brief Entry point of the cache service shared by all gallery3 slaves
+ * The service is started on demand by the slaves and terminates itself when
+ * it has not been used for a while.
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+
+#include <unistd.h>
+
+#include <QCoreApplication>
+#include <kcomponentdata.h>
+#include <kdebug.h>
+#include "utility/defines.h"
+#include "service/g3_cache_service.h"
+
+int main ( int argc, char **argv )
+{
+  QCoreApplication app ( argc, argv );
+  KComponentData componentData ( "kio_gallery3_cached" );
+  kDebug() << QString("started cache service '%1' with PID %2").arg(argv[0]).arg(getpid());
+  KIO::Gallery3::G3CacheService service;
+  if ( ! service.listen() )
+    return ( 0 );
+  int result = app.exec ( );
+  kDebug() << QString("stopped cache service '%1' with PID %2").arg(argv[0]).arg(getpid());
+  return ( result );
+} // main
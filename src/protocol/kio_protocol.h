@@ -45,7 +45,7 @@ namespace KIO
         ~KIOProtocol ( );
       protected:
       public:
-        virtual void setHost  ( const QString& host, g3index port, const QString& user, const QString& pass ) = 0; 
+        virtual void setHost  ( const QString& host, quint16 port, const QString& user, const QString& pass ) = 0; 
         virtual void copy     ( const KUrl& src, const KUrl& dest, int permissions, JobFlags flags ) = 0;
         virtual void del      ( const KUrl& url, bool isfile ) = 0;
         virtual void get      ( const KUrl& url ) = 0;
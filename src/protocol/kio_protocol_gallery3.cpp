@@ -15,6 +15,7 @@
 
 #include <stdlib.h>
 #include <unistd.h>
+#include <QDataStream>
 #include <KUrl>
 #include <KMimeType>
 #include <klocalizedstring.h>
@@ -25,15 +26,17 @@
 #include <kstandarddirs.h>
 #include "utility/exception.h"
 #include "gallery3/g3_backend.h"
+#include "gallery3/g3_cache.h"
 #include "protocol/kio_protocol_gallery3.h"
 #include "entity/g3_item.h"
 #include "entity/g3_file.h"
+#include "protocol/kio_put_source.h"
 
 using namespace KIO;
 using namespace KIO::Gallery3;
 
 /*!
- * void KIOGallery3Protocol::selectConnection ( const QString& host, g3index port, const QString& user, const QString& pass )
+ * void KIOGallery3Protocol::selectConnection ( const QString& host, quint16 port, const QString& user, const QString& pass )
  * @brief Static method to set active remote connection
  * @param host host to connect to
  * @param port tcp port to connect to
@@ -44,7 +47,7 @@ using namespace KIO::Gallery3;
  * @see KIOGallery3Protocol
  * @author Christian Reiner
  */
-void KIOGallery3Protocol::selectConnection ( const QString& host, qint16 port, const QString& user, const QString& pass )
+void KIOGallery3Protocol::selectConnection ( const QString& host, quint16 port, const QString& user, const QString& pass )
 {
   KDebug::Block block ( "KIOGallery3Protocol::selectConnection" );
   kDebug() << "(<host> <port> <user> <pass>)" << host << port << user << ( pass.isEmpty() ? "" : "<hidden password>" );
@@ -319,36 +322,6 @@ void KIOGallery3Protocol::slotMessageBox ( int& result, const QString &text, Sla
   kDebug() << text << caption << ">>" << result << dontAskAgainName;
 } // KIOGallery3Protocol::slotMessageBox
 
-/*!
- * void KIOGallery3Protocol::slotListUDSEntries ( const UDSEntryList entries )
- * @brief Publish list of items
- * @param entries list of UDS entries
- * Accepts a list of UDSEntries describing items inside the item hierarchy.
- * Typically used to publish parts of a large set of members inside an album. 
- * @see KIOGallery3Protocol
- * @author Christian Reiner
- */
-void KIOGallery3Protocol::slotListUDSEntries ( const UDSEntryList entries )
-{
-  kDebug() << "(<UDSEntries[count]>)" << entries.count();
-  listEntries ( entries );
-} // KIOGallery3Protocol::slotListUDSEntries
-
-/*!
- * void KIOGallery3Protocol::slotListUDSEntry ( const UDSEntry entry )
- * @brief Publish single item as part of a list
- * @param entry single UDS entry
- * Accepts a single UDSEntry describing an item inside the item hierarchy.
- * Typically used to publish an item being part of the set of members of an album. 
- * @see KIOGallery3Protocol
- * @author Christian Reiner
- */
-void KIOGallery3Protocol::slotListUDSEntry ( const UDSEntry entry )
-{
-  kDebug() << "(<UDSEntry>)" << entry.stringValue ( UDSEntry::UDS_NAME );
-  listEntry ( entry, FALSE );
-} // KIOGallery3Protocol::slotListUDSEntry
-
 /*!
  * void KIOGallery3Protocol::slotStatUDSEntry ( const UDSEntry entry )
  * @brief Publish single item
@@ -394,10 +367,79 @@ void KIOGallery3Protocol::slotMimetype ( KIO::Job* job, const QString& type )
   mimeType ( type );
 } // KIOGallery3Protocol::slotMimetype
 
+/*!
+ * void KIOGallery3Protocol::slotUploadProgress ( qint64 processed, qint64 total )
+ * @brief Publish the progress of an upload
+ * @param processed number of bytes of the file sent so far
+ * @param total     size of the file
+ * Forwards the progress of an upload to the calling scope. The total size
+ * has been announced by put() before the upload started.
+ * @see KIOGallery3Protocol
+ * @see G3Multipart
+ * @author Christian Reiner
+ */
+void KIOGallery3Protocol::slotUploadProgress ( qint64 processed, qint64 total )
+{
+  kDebug() << "(<processed> <total>)" << processed << total;
+  processedSize ( processed );
+} // KIOGallery3Protocol::slotUploadProgress
+
 //======================
 
 /*!
- * void KIOGallery3Protocol::setHost ( const QString& host, g3index port, const QString& user, const QString& pass )
+ * void KIOGallery3Protocol::dispatch ( int command, const QByteArray& data )
+ * @brief Processes a single command of the calling scope
+ * @param command the command to be processed
+ * @param data    arguments of the command
+ * After each command, when no item is in use, the items of all backends are
+ * kept within their memory budget. The work left for the slave to do when it
+ * becomes idle is scheduled again, each command postpones it.
+ * @see G3Backend::evictItems
+ * @see KIOGallery3Protocol::scheduleIdle
+ * @see KIOGallery3Protocol
+ * @author Christian Reiner
+ */
+void KIOGallery3Protocol::dispatch ( int command, const QByteArray& data )
+{
+  SlaveBase::dispatch ( command, data );
+  foreach ( G3Backend* backend, m->backends )
+  {
+    try { backend->evictItems ( ); }
+    catch ( Exception &e ) { kDebug() << "failed to evict items:" << e.getText(); }
+  } // foreach
+  scheduleIdle ( );
+} // KIOGallery3Protocol::dispatch
+
+/*!
+ * void KIOGallery3Protocol::scheduleIdle ( )
+ * @brief Schedules the work to be done when the slave is idle
+ * There is only a single timeout special command, so the work is done in
+ * order: the items used by the last commands are revalidated first, in steps
+ * of a limited size, changed cache records are written afterwards.
+ * @see KIOGallery3Protocol::special
+ * @see KIOGallery3Protocol
+ * @author Christian Reiner
+ */
+void KIOGallery3Protocol::scheduleIdle ( )
+{
+  bool stale = FALSE;
+  bool dirty = FALSE;
+  foreach ( G3Backend* backend, m->backends )
+  {
+    stale = stale || backend->hasUsedItems ( );
+    dirty = dirty || ( backend->cache() && backend->cache()->isDirty() );
+  } // foreach
+  if ( stale || dirty )
+  {
+    QByteArray special;
+    QDataStream stream ( &special, QIODevice::WriteOnly );
+    stream << int( stale ? REVALIDATE : FLUSH_CACHE );
+    setTimeoutSpecialCommand ( stale ? ITEM_REVALIDATE_IDLE : ITEM_CACHE_FLUSH, special );
+  }
+} // KIOGallery3Protocol::scheduleIdle
+
+/*!
+ * void KIOGallery3Protocol::setHost ( const QString& host, quint16 port, const QString& user, const QString& pass )
  * @brief Allows the calling scope to set connection details
  * @param host host where to contact a remote Gallery3 system
  * @param port tcp port where to contact a remote Gallery3 system
@@ -409,7 +451,7 @@ void KIOGallery3Protocol::slotMimetype ( KIO::Job* job, const QString& type )
  * @see KIOGallery3Protocol
  * @author Christian Reiner
  */
-void KIOGallery3Protocol::setHost ( const QString& host, g3index port, const QString& user, const QString& pass )
+void KIOGallery3Protocol::setHost ( const QString& host, quint16 port, const QString& user, const QString& pass )
 {
   KDebug::Block block ( "KIOGallery3Protocol::setHost" );
   kDebug() << "(<host> <port> <user> <pass>)" << host << port << user << ( pass.isEmpty() ? "" : "<hidden password>" );
@@ -538,27 +580,18 @@ void KIOGallery3Protocol::listDir ( const KUrl& targetUrl )
     {
       G3Item* item = itemBase ( targetUrl );
       kDebug() << "listing base entries members";
-      totalSize   ( item->countMembers() );
-      connect ( item, SIGNAL(signalUDSEntry(const UDSEntry)),
-                this, SLOT(slotListUDSEntry(const UDSEntry)) );
-//      listEntries ( item->toUDSEntryList(TRUE) );
-      item->toUDSEntryList(TRUE);
+      totalSize   ( item->countMemberIds() );
+      item->listMemberItems ( this );
       listEntry ( UDSEntry(), TRUE );
-      disconnect ( item, SIGNAL(signalUDSEntry(const UDSEntry)),
-                   this, SLOT(slotListUDSEntry(const UDSEntry)) );
       finished ( );
     } // else if
     else
     {
       G3Item* item = itemByUrl ( targetUrl );
       kDebug() << "listing items members";
-      totalSize   ( item->countMembers() );
-      connect ( item, SIGNAL(signalUDSEntry(const UDSEntry)),
-                this, SLOT(slotListUDSEntry(const UDSEntry)) );
-      listEntries ( item->toUDSEntryList(TRUE) );
+      totalSize   ( item->countMemberIds() );
+      item->listMemberItems ( this );
       listEntry ( UDSEntry(), TRUE );
-      disconnect ( item, SIGNAL(signalUDSEntry(const UDSEntry)),
-                   this, SLOT(slotListUDSEntry(const UDSEntry)) );
       finished ( );
     } // else
   }
@@ -622,6 +655,11 @@ void KIOGallery3Protocol::mkdir ( const KUrl& targetUrl, int permissions )
  * @param flags       flags controlling the creation action
  * Called to create a new item inside the remote Gallery3 system.
  * Also uploads a file provided by the calling scope in case of photos and movies. 
+ * The data is streamed into the upload if its size is known in advance and a
+ * remote access key is present, otherwise it is buffered in a temporary file
+ * first, so the upload can be repeated after an authentication.
+ * Streamed data exceeding the announced size is an error, the item created
+ * from the truncated data is removed again.
  * @see KIOGallery3Protocol
  * @author Christian Reiner
  */
@@ -631,38 +669,64 @@ void KIOGallery3Protocol::put ( const KUrl& targetUrl, int permissions, KIO::Job
   kDebug() << "(<url, <permissions> <flags>)" << targetUrl << permissions << flags;
   try
   {
-    // strategy: save data stream to temp file and http-post that
-    QByteArray     buffer;
+    G3Backend* backend  = selectBackend ( targetUrl );
+    G3Item*    parent   = backend->itemByPath ( targetUrl.directory() );
+    QString    filename = targetUrl.fileName ( );
+    // the first piece of data is used to detect the mimetype
+    QByteArray buffer;
+    dataReq ( );
+    if ( 0>readData(buffer) )
+      throw Exception ( Error(ERR_COULD_NOT_READ),i18n("failed to read data to be uploaded to '%1'").arg(targetUrl.prettyUrl()) );
+    KMimeType::Ptr mimetype = KMimeType::findByNameAndContent ( filename, buffer );
+    // strategy: stream the data directly into the upload if its size is known in advance
+    // a stream cannot be sent again, so without an access key, which most likely
+    // results in a request for authentication, the temporary file is used
+    bool    valid = FALSE;
+    qint64  size  = metaData("sourceSize").toLongLong ( &valid );
+    if (   valid && 0<size
+        && ! backend->credentials().digestInfo.isEmpty()
+        && backend->settings().readEntry("StreamingUpload",TRUE) )
+    {
+      kDebug() << "streaming" << size << "bytes of content to upload";
+      KIOPutSource source ( this, buffer );
+      source.open ( QIODevice::ReadOnly | QIODevice::Unbuffered );
+      G3File g3file ( filename, mimetype, &source, size );
+      totalSize ( size );
+      G3Item* item = backend->createItem ( parent, filename, &g3file );
+      // the calling scope might send more data than it has announced
+      qint64 excess = source.drain ( );
+      if ( 0>excess )
+        throw Exception ( Error(ERR_COULD_NOT_READ),i18n("failed to read data to be uploaded to '%1'").arg(targetUrl.prettyUrl()) );
+      if ( 0<excess )
+      {
+        kDebug() << "content exceeds the announced size by" << excess << "bytes, removing item" << item->toPrintout();
+        backend->removeItem ( item );
+        throw Exception ( Error(ERR_COULD_NOT_WRITE),
+                          i18n("content uploaded to '%1' exceeds its announced size of %2 bytes").arg(targetUrl.prettyUrl()).arg(size) );
+      }
+      finished ( );
+      return;
+    } // if
+    // fallback strategy: save data stream to temp file and http-post that
     KTemporaryFile file;
-//    if ( ! file.open(QIODevice::WriteOnly) )
     if ( ! file.open() )
       throw Exception ( Error(ERR_COULD_NOT_WRITE),i18n("failed to generate temporary file '%1'").arg(file.fileName()) );
     kDebug() << "using temporary file" << file.fileName() << "to upload content";
-    int read_count=0, write_count=0;
-    do
+    int read_count=buffer.size(), write_count=file.write(buffer);
+    while ( 0<read_count && 0<=write_count ) // a return value of 0 (zero) means: no more data
     {
       dataReq();
       buffer.clear ( );
       read_count  = readData ( buffer );
       write_count = file.write ( buffer );
-      if  ( read_count<0 || write_count<0)
-        throw Exception ( Error(ERR_SLAVE_DEFINED),i18n("failed to buffer data in temporary file").arg(targetUrl.prettyUrl()) );
-    } while ( read_count>0 ); // a return value of 0 (zero) means: no more data
+    } // while
+    if  ( read_count<0 || write_count<0 )
+      throw Exception ( Error(ERR_SLAVE_DEFINED),i18n("failed to buffer data in temporary file '%1'").arg(file.fileName()) );
     file.close ( );
-    // upload stream as new file to remote gallery
-    G3Backend* backend = selectBackend ( targetUrl );
-    // upload temporary file to server
-    QString source = KStandardDirs::locate ( "tmp", file.fileName() );
-    if ( source.isEmpty() )
-      throw Exception ( Error(ERR_INTERNAL),i18n("failure while handling temporary file '%1'").arg(file.fileName()) );
-    KMimeType::Ptr mimetype = KMimeType::findByPath ( source );
-    QString        filename = targetUrl.fileName ( );
-    G3Item* parent = backend->itemByPath ( targetUrl.directory() );
     // the backend part handles the upload request
-    G3File g3file ( filename, mimetype, source );
+    G3File g3file ( filename, mimetype, file.fileName() );
+    totalSize ( file.size() );
     backend->createItem ( parent, filename, &g3file );
-    // cleanup
-    file.deleteLater ( );
     finished ( );
   }
   catch ( Exception &e ) { error( e.getCode(), e.getText() ); }
@@ -746,8 +810,14 @@ void KIOGallery3Protocol::stat ( const KUrl& targetUrl )
     }
     else
     {
-      // non-root element
-      const G3Item* item = itemByUrl ( targetUrl );
+      // non-root element, a missing item is a regular answer here
+      G3Backend* backend = selectBackend ( targetUrl );
+      const G3Item* item = backend->findItemByPath ( KUrl::relativeUrl(backend->baseUrl(),targetUrl) );
+      if ( NULL==item )
+      {
+        error ( ERR_DOES_NOT_EXIST, targetUrl.prettyUrl() );
+        return;
+      }
       mimeType  ( item->mimetype()->name() );
       statEntry ( item->toUDSEntry() );
       finished  ( );
@@ -790,6 +860,11 @@ void KIOGallery3Protocol::symlink ( const QString& target, const KUrl& dest, KIO
  * item attributes beside name and position and so on.
  * The structure of the data is implementation specific, thus it is up to the implementing
  * slave to define it and to the calling scope to know about that :-)
+ * The data starts with an int holding one of the Special commands. Currently only
+ * REVALIDATE and FLUSH_CACHE are known, both are issued by the slave itself when
+ * it becomes idle: REVALIDATE revalidates a step of the items used before,
+ * FLUSH_CACHE writes the changed records of all caches to disk.
+ * @see KIOGallery3Protocol::scheduleIdle
  * @see KIOGallery3Protocol
  * @author Christian Reiner
  */
@@ -806,6 +881,28 @@ Reimplemented in FileProtocol, and HTTPProtocol.
   kDebug() << "(<data>)";
   try
   {
+    int command = 0;
+    QDataStream stream ( data );
+    stream >> command;
+    // issued as timeout commands, so they must not be answered
+    if ( REVALIDATE==command )
+    {
+      foreach ( G3Backend* backend, m->backends )
+      {
+        // a failed revalidation is simply tried again when the items are used again
+        try { backend->revalidateItems ( ITEM_REVALIDATE_STEP ); }
+        catch ( Exception &e ) { kDebug() << "failed to revalidate items:" << e.getText(); }
+      } // foreach
+      scheduleIdle ( );
+      return;
+    }
+    if ( FLUSH_CACHE==command )
+    {
+      foreach ( G3Backend* backend, m->backends )
+        if ( backend->cache() )
+          backend->cache()->flush ( );
+      return;
+    }
     throw Exception ( Error(ERR_UNSUPPORTED_ACTION),i18n("sorry, currently not implemented...") );
   }
   catch ( Exception &e ) { error( e.getCode(), e.getText() ); }
@@ -46,6 +46,8 @@ namespace KIO
       , public KIOProtocol
     {
       Q_OBJECT
+      public:
+        enum Special { FLUSH_CACHE=1, REVALIDATE=2 };
       private:
         class Members
         {
@@ -54,7 +56,7 @@ namespace KIO
             struct
             {
               QString host;
-              g3index port;
+              quint16 port;
               QString user;
               QString pass;
             } connection;
@@ -63,11 +65,12 @@ namespace KIO
       private:
         Members* const m;
       protected:
-        void           selectConnection ( const QString& host, qint16 port, const QString& user, const QString& pass );
+        void           selectConnection ( const QString& host, quint16 port, const QString& user, const QString& pass );
         G3Backend*     selectBackend    ( const KUrl& base );
         G3Item*        itemBase         ( const KUrl& itemUrl );
         G3Item*        itemByUrl        ( const KUrl& itemUrl );
         QList<G3Item*> itemsByUrl       ( const KUrl& itemUrl );
+        void           scheduleIdle     ( );
       public:
         inline const QString protocol ( ) { return QString("gallery3"); }
         KIOGallery3Protocol ( const QByteArray &pool, const QByteArray &app, QObject* parent=0 );
@@ -76,13 +79,12 @@ namespace KIO
         void slotRequestAuthInfo ( G3Backend* backend, AuthInfo& credentials, int attempt );
         void slotMessageBox      ( int& result, MessageBoxType type, const QString &text, const QString &caption=QString(), const QString &buttonYes=i18n("&Yes"), const QString &buttonNo=i18n("&No") );
         void slotMessageBox      ( int& result, const QString &text, MessageBoxType type, const QString &caption=QString(), const QString &buttonYes=i18n("&Yes"), const QString &buttonNo=i18n("&No"), const QString &dontAskAgainName=QString() );
-        void slotListUDSEntries  ( const UDSEntryList entries );
-        void slotListUDSEntry    ( const UDSEntry entry );
         void slotStatUDSEntry    ( const UDSEntry entry );
         void slotData            ( KIO::Job* job, const QByteArray& data );
         void slotMimetype        ( KIO::Job* job, const QString& type );
+        void slotUploadProgress  ( qint64 processed, qint64 total );
       public:
-        void setHost  ( const QString& host, g3index port, const QString& user, const QString& pass );
+        void setHost  ( const QString& host, quint16 port, const QString& user, const QString& pass );
         void copy     ( const KUrl& src, const KUrl& dest, int permissions, JobFlags flags );
         void del      ( const KUrl& url, bool isfile );
         void get      ( const KUrl& url );
@@ -95,6 +97,7 @@ namespace KIO
         void stat     ( const KUrl& url );
         void symlink  ( const QString& target, const KUrl& dest, KIO::JobFlags flags );
         void special  ( const QByteArray& data );
+        void dispatch ( int command, const QByteArray& data );
     }; // class KIOGallery3Protocol
 
   } // namespace Gallery3
@@ -0,0 +1,139 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * @brief Implements the methods of class KIOPutSource
+ * @see KIOPutSource
+ * @author Christian Reiner
+ */
+
+#include <string.h>
+#include <kdebug.h>
+#include "protocol/kio_put_source.h"
+
+using namespace KIO;
+using namespace KIO::Gallery3;
+
+/*!
+ * KIOPutSource::KIOPutSource ( SlaveBase* slave, const QByteArray& buffer, QObject* parent )
+ * @brief Constructor
+ * @param slave  the slave processing the 'put' command
+ * @param buffer piece of data that has been read from the calling scope already
+ * @param parent owning object
+ * @see KIOPutSource
+ * @author Christian Reiner
+ */
+KIOPutSource::KIOPutSource ( SlaveBase* slave, const QByteArray& buffer, QObject* parent )
+  : QIODevice ( parent )
+  , m         ( new KIOPutSource::Members(slave,buffer) )
+{
+  kDebug() << "(<slave> <buffer[size]>)" << buffer.size();
+} // KIOPutSource::KIOPutSource
+
+/*!
+ * KIOPutSource::~KIOPutSource ( )
+ * @brief Destructor
+ * @see KIOPutSource
+ * @author Christian Reiner
+ */
+KIOPutSource::~KIOPutSource ( )
+{
+  kDebug() << "(<>)";
+  // delete private members
+  delete m;
+} // KIOPutSource::~KIOPutSource
+
+//==========
+
+/*!
+ * bool KIOPutSource::atEnd ( ) const
+ * @brief Tells if the calling scope has sent all data
+ * @return TRUE if all data has been handed out, FALSE otherwise
+ * @see KIOPutSource
+ * @author Christian Reiner
+ */
+bool KIOPutSource::atEnd ( ) const
+{
+  return m->finished && m->position>=m->buffer.size();
+} // KIOPutSource::atEnd
+
+/*!
+ * qint64 KIOPutSource::readData ( char* data, qint64 maxSize )
+ * @brief Provides the next piece of data
+ * @param  data    buffer to be filled
+ * @param  maxSize size of the buffer
+ * @return         number of bytes provided, 0 at the end of data, -1 in case of an error
+ * Requests the next piece of data from the calling scope when the current one
+ * has been handed out completely.
+ * @see KIOPutSource
+ * @author Christian Reiner
+ */
+qint64 KIOPutSource::readData ( char* data, qint64 maxSize )
+{
+  if ( m->position>=m->buffer.size() )
+  {
+    if ( m->finished )
+      return 0;
+    m->buffer.clear ( );
+    m->position = 0;
+    m->slave->dataReq ( );
+    int count = m->slave->readData ( m->buffer );
+    if ( 0>count )
+    {
+      kDebug() << "failed to read data from calling scope";
+      setErrorString ( QLatin1String("failed to read data from calling scope") );
+      return -1;
+    }
+    // a return value of 0 (zero) means: no more data
+    if ( 0==count )
+    {
+      m->finished = TRUE;
+      return 0;
+    }
+  } // if
+  qint64 count = qMin ( maxSize, qint64(m->buffer.size()-m->position) );
+  memcpy ( data, m->buffer.constData()+m->position, count );
+  m->position += count;
+  return count;
+} // KIOPutSource::readData
+
+/*!
+ * qint64 KIOPutSource::drain ( )
+ * @brief Reads all data not handed out yet
+ * @return number of bytes skipped, -1 in case of an error
+ * The calling scope expects all data to be read, so data sent beyond the
+ * announced size is consumed to detect it.
+ * @see KIOPutSource
+ * @author Christian Reiner
+ */
+qint64 KIOPutSource::drain ( )
+{
+  qint64 count = 0;
+  char   data[UPLOAD_CHUNK_SIZE];
+  qint64 chunk;
+  while ( 0<(chunk=readData(data,sizeof(data))) )
+    count += chunk;
+  return ( 0>chunk ) ? -1 : count;
+} // KIOPutSource::drain
+
+/*!
+ * qint64 KIOPutSource::writeData ( const char* data, qint64 maxSize )
+ * @brief The device is read only
+ * @return always -1
+ * @see KIOPutSource
+ * @author Christian Reiner
+ */
+qint64 KIOPutSource::writeData ( const char* data, qint64 maxSize )
+{
+  Q_UNUSED ( data );
+  Q_UNUSED ( maxSize );
+  return -1;
+} // KIOPutSource::writeData
+
+#include "protocol/kio_put_source.moc"
@@ -0,0 +1,70 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * Defines class KIOPutSource
+ * A device that reads the data of a 'put' command directly from the
+ * calling scope, so it can be streamed into an upload.
+ * @see KIOPutSource
+ * @author Christian Reiner
+ */
+
+#ifndef KIO_PUT_SOURCE_H
+#define KIO_PUT_SOURCE_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <kio/slavebase.h>
+#include "utility/defines.h"
+
+namespace KIO
+{
+  namespace Gallery3
+  {
+
+    /*!
+     * @class KIOPutSource
+     * @brief Sequential device reading the data of a 'put' command
+     * Each time more data is required the device requests the next piece from
+     * the calling scope via SlaveBase::dataReq() and SlaveBase::readData().
+     * The piece read before (typically to detect the mimetype) is handed out
+     * first. Note that the data can only be read once, a transfer using this
+     * device cannot be restarted.
+     * @author Christian Reiner
+     */
+    class KIOPutSource
+      : public QIODevice
+    {
+      class Members
+      {
+        public:
+          inline Members ( SlaveBase* slave, const QByteArray& buffer ) : slave(slave), buffer(buffer), position(0), finished(FALSE) { }
+          SlaveBase* const slave;
+          QByteArray       buffer;   // piece of data not yet handed out completely
+          int              position; // bytes of the buffer handed out already
+          bool             finished; // the calling scope has sent all data
+      }; // class Members
+      Q_OBJECT
+      private:
+        Members* const m;
+      protected:
+        qint64 readData  ( char* data, qint64 maxSize );
+        qint64 writeData ( const char* data, qint64 maxSize );
+      public:
+        KIOPutSource ( SlaveBase* slave, const QByteArray& buffer, QObject* parent=NULL );
+        ~KIOPutSource ( );
+        inline bool isSequential ( ) const { return TRUE; }
+        bool        atEnd        ( ) const;
+        qint64      drain        ( );
+    }; // class KIOPutSource
+
+  } // namespace Gallery3
+} // namespace KIO
+
+#endif // KIO_PUT_SOURCE_H
@@ -0,0 +1,285 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * @brief Implements the methods of class G3CacheService
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QPair>
+#include <QVector>
+#include <QtAlgorithms>
+#include <kdebug.h>
+#include "gallery3/g3_cache_client.h"
+#include "service/g3_cache_service.h"
+
+using namespace KIO;
+using namespace KIO::Gallery3;
+
+/*!
+ * G3CacheService::G3CacheService ( QObject* parent )
+ * @brief Constructor
+ * @param parent owning object
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+G3CacheService::G3CacheService ( QObject* parent )
+  : QObject ( parent )
+  , m       ( new G3CacheService::Members )
+{
+  KDebug::Block block ( "G3CacheService::G3CacheService" );
+  m->idle.setSingleShot ( TRUE );
+  m->idle.setInterval   ( 1000*ITEM_CACHE_SERVICE_IDLE );
+  connect ( &m->idle,   SIGNAL(timeout()),       this, SLOT(slotIdle()) );
+  connect ( &m->server, SIGNAL(newConnection()), this, SLOT(slotNewConnection()) );
+} // G3CacheService::G3CacheService
+
+/*!
+ * G3CacheService::~G3CacheService ( )
+ * @brief Destructor
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+G3CacheService::~G3CacheService ( )
+{
+  KDebug::Block block ( "G3CacheService::~G3CacheService" );
+  kDebug() << "(<>)" << m->galleries.count() << "galleries";
+  m->server.close ( );
+  // delete private members
+  delete m;
+} // G3CacheService::~G3CacheService
+
+//==========
+
+/*!
+ * bool G3CacheService::listen ( )
+ * @brief Starts to accept connections of slaves
+ * @return TRUE if the service is listening, FALSE if another instance is running already
+ * A socket left behind by a crashed service is removed.
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+bool G3CacheService::listen ( )
+{
+  KDebug::Block block ( "G3CacheService::listen" );
+  QString name = G3CacheClient::serviceName ( );
+  kDebug() << "(<>)" << name;
+  // another instance might have been started at the same time
+  QLocalSocket probe;
+  probe.connectToServer ( name );
+  if ( probe.waitForConnected(ITEM_CACHE_SERVICE_TIMEOUT) )
+  {
+    kDebug() << "cache service is already running";
+    return FALSE;
+  }
+  QLocalServer::removeServer ( name );
+  if ( ! m->server.listen(name) )
+  {
+    kDebug() << "failed to listen on" << name << m->server.errorString();
+    return FALSE;
+  }
+  m->idle.start ( );
+  return TRUE;
+} // G3CacheService::listen
+
+/*!
+ * void G3CacheService::process ( QLocalSocket* socket, const QByteArray& message )
+ * @brief Processes a single message of a slave
+ * @param socket  connection the message has been received on
+ * @param message the message without its length prefix
+ * A lookup is answered by all records found of the requested items, a single
+ * message for any number of items. Records found or stored are stamped as
+ * used, so the least recently used ones are dropped first.
+ * @see G3CacheService
+ * @see G3CacheClient
+ * @author Christian Reiner
+ */
+void G3CacheService::process ( QLocalSocket* socket, const QByteArray& message )
+{
+  QDataStream stream ( message );
+  quint8  command;
+  QString gallery;
+  stream >> command >> gallery;
+  m->clock++;
+  switch ( command )
+  {
+    case G3CacheClient::LOOKUP:
+    {
+      QVector<g3index> ids;
+      stream >> ids;
+      // a lookup must not create an empty gallery
+      QHash<QString,QHash<g3index,Entry> >::iterator records = m->galleries.find ( gallery );
+      QVector<g3index> found;
+      if ( m->galleries.end()!=records )
+        foreach ( g3index id, ids )
+        {
+          QHash<g3index,Entry>::iterator entry = records->find ( id );
+          if ( records->end()==entry )
+            continue;
+          entry->used = m->clock;
+          found << id;
+        } // foreach
+      QByteArray answer;
+      QDataStream reply ( &answer, QIODevice::WriteOnly );
+      reply << quint32(found.count());
+      foreach ( g3index id, found )
+      {
+        const G3Cache::Record& record = records->value(id).record;
+        reply << quint32(id) << record.fetched << record.updated << record.blob;
+      }
+      QDataStream frame ( socket );
+      frame << answer;
+      break;
+    }
+    case G3CacheClient::STORE:
+    {
+      quint32 id;
+      Entry   entry;
+      stream >> id >> entry.record.fetched >> entry.record.updated >> entry.record.blob;
+      if ( QDataStream::Ok!=stream.status() )
+        break;
+      entry.used = m->clock;
+      QHash<g3index,Entry>& records = m->galleries[gallery];
+      if ( ! records.contains(id) )
+        m->count++;
+      records.insert ( id, entry );
+      if ( ITEM_CACHE_SERVICE_RECORDS<m->count )
+        evict ( );
+      break;
+    }
+    case G3CacheClient::DROP:
+    {
+      quint32 id;
+      stream >> id;
+      QHash<QString,QHash<g3index,Entry> >::iterator records = m->galleries.find ( gallery );
+      if ( m->galleries.end()==records )
+        break;
+      m->count -= records->remove ( id );
+      if ( records->isEmpty() )
+        m->galleries.erase ( records );
+      break;
+    }
+    default:
+      kDebug() << "ignoring unknown command" << command;
+  } // switch
+} // G3CacheService::process
+
+/*!
+ * void G3CacheService::evict ( )
+ * @brief Drops the least recently used records
+ * The records of all galleries are sorted by the time they were used last
+ * and the oldest quarter is dropped, so the sorting is only required once
+ * in a while.
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+void G3CacheService::evict ( )
+{
+  KDebug::Block block ( "G3CacheService::evict" );
+  kDebug() << "(<>)" << m->count << "records";
+  QVector<QPair<quint64,QPair<QString,g3index> > > entries;
+  entries.reserve ( m->count );
+  QHash<QString,QHash<g3index,Entry> >::const_iterator gallery;
+  for ( gallery=m->galleries.constBegin(); gallery!=m->galleries.constEnd(); gallery++ )
+  {
+    QHash<g3index,Entry>::const_iterator entry;
+    for ( entry=gallery.value().constBegin(); entry!=gallery.value().constEnd(); entry++ )
+      entries << qMakePair ( entry.value().used, qMakePair(gallery.key(),entry.key()) );
+  } // for
+  qSort ( entries );
+  for ( int pos=0; pos<entries.count()/4; pos++ )
+  {
+    QHash<QString,QHash<g3index,Entry> >::iterator records = m->galleries.find ( entries.at(pos).second.first );
+    m->count -= records->remove ( entries.at(pos).second.second );
+    if ( records->isEmpty() )
+      m->galleries.erase ( records );
+  } // for
+  kDebug() << "kept" << m->count << "records of" << m->galleries.count() << "galleries";
+} // G3CacheService::evict
+
+//==========
+
+/*!
+ * void G3CacheService::slotNewConnection ( )
+ * @brief Accepts connections of slaves
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+void G3CacheService::slotNewConnection ( )
+{
+  while ( m->server.hasPendingConnections() )
+  {
+    QLocalSocket* socket = m->server.nextPendingConnection ( );
+    kDebug() << "accepted connection" << m->buffers.count()+1;
+    m->buffers.insert ( socket, QByteArray() );
+    connect ( socket, SIGNAL(readyRead()),    this,   SLOT(slotReadyRead()) );
+    connect ( socket, SIGNAL(disconnected()), this,   SLOT(slotDisconnected()) );
+    connect ( socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()) );
+  } // while
+  m->idle.stop ( );
+} // G3CacheService::slotNewConnection
+
+/*!
+ * void G3CacheService::slotReadyRead ( )
+ * @brief Collects messages of a slave
+ * Data arrives in arbitrary pieces, so it is buffered until a complete
+ * message (as announced by its length prefix) is available.
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+void G3CacheService::slotReadyRead ( )
+{
+  QLocalSocket* socket = qobject_cast<QLocalSocket*> ( sender() );
+  if ( ! socket || ! m->buffers.contains(socket) )
+    return;
+  QByteArray& buffer = m->buffers[socket];
+  buffer.append ( socket->readAll() );
+  while ( sizeof(quint32)<=uint(buffer.size()) )
+  {
+    QDataStream stream ( buffer );
+    quint32 size;
+    stream >> size;
+    if ( sizeof(quint32)+size>uint(buffer.size()) )
+      break;
+    process ( socket, buffer.mid(sizeof(quint32),size) );
+    buffer.remove ( 0, sizeof(quint32)+size );
+  } // while
+} // G3CacheService::slotReadyRead
+
+/*!
+ * void G3CacheService::slotDisconnected ( )
+ * @brief Forgets about a terminated slave
+ * The service becomes idle when the last slave has gone.
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+void G3CacheService::slotDisconnected ( )
+{
+  m->buffers.remove ( static_cast<QLocalSocket*>(sender()) );
+  kDebug() << "connection closed," << m->buffers.count() << "left";
+  if ( m->buffers.isEmpty() )
+    m->idle.start ( );
+} // G3CacheService::slotDisconnected
+
+/*!
+ * void G3CacheService::slotIdle ( )
+ * @brief Terminates the service after it has not been used for a while
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+void G3CacheService::slotIdle ( )
+{
+  kDebug() << "terminating idle cache service";
+  QCoreApplication::quit ( );
+} // G3CacheService::slotIdle
+
+#include "service/g3_cache_service.moc"
@@ -0,0 +1,85 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * Defines class G3CacheService
+ * The cache service is a separate process that keeps the item descriptions
+ * retrieved by all slaves of the local user.
+ * @see G3CacheService
+ * @author Christian Reiner
+ */
+
+#ifndef G3_CACHE_SERVICE_H
+#define G3_CACHE_SERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include "utility/defines.h"
+#include "gallery3/g3_cache.h"
+
+namespace KIO
+{
+  namespace Gallery3
+  {
+
+    /*!
+     * @class G3CacheService
+     * @brief Item cache shared by concurrent slaves
+     * Listens on a local socket and answers the messages of G3CacheClient
+     * objects. Records are kept per gallery in memory only, the persistent
+     * cache files remain the business of the slaves. The number of records is
+     * bounded by ITEM_CACHE_SERVICE_RECORDS, the least recently used records
+     * are dropped when it is exceeded.
+     * The service terminates itself after having been idle for a while.
+     * @see G3CacheClient
+     * @author Christian Reiner
+     */
+    class G3CacheService
+      : public QObject
+    {
+      struct Entry
+      {
+        G3Cache::Record record;
+        quint64         used;  // stamp of the last message storing or finding the record
+      }; // struct Entry
+      class Members
+      {
+        public:
+          inline Members ( ) : count(0), clock(0) { }
+          QLocalServer                                       server;
+          QTimer                                             idle;
+          QHash<QLocalSocket*,QByteArray>                    buffers;   // partial messages by connection
+          QHash<QString,QHash<g3index,Entry> >               galleries; // records by gallery and item id
+          int                                                count;     // number of records of all galleries
+          quint64                                            clock;     // stamp of the current message
+      }; // class Members
+      Q_OBJECT
+      private:
+        Members* const m;
+      protected:
+        void process ( QLocalSocket* socket, const QByteArray& message );
+        void evict   ( );
+      public:
+        G3CacheService ( QObject* parent=NULL );
+        ~G3CacheService ( );
+        bool listen ( );
+      private slots:
+        void slotNewConnection ( );
+        void slotReadyRead     ( );
+        void slotDisconnected  ( );
+        void slotIdle          ( );
+    }; // class G3CacheService
+
+  } // namespace Gallery3
+} // namespace KIO
+
+#endif // G3_CACHE_SERVICE_H
@@ -23,17 +23,197 @@
  * system. The idea is to have a balance between side of request and reply
  * on the one hand and number of requests required on the other hand. 
  * Best value actually depends on the implementation of the Gallery3 code.
+ * Can be overridden per gallery by the setting 'ItemChunkSize'.
  */
 #define ITEM_LIST_CHUNK_SIZE 8
 
 /*!
- * @typedef quint16 g3index
+ * @config ITEM_LIST_CHUNK_SIZE_MAX
+ * The upper limit the chunk size may grow to in adaptive mode.
+ * Can be overridden per gallery by the setting 'ItemChunkSizeMax'.
+ */
+#define ITEM_LIST_CHUNK_SIZE_MAX 128
+
+/*!
+ * @config ITEM_LIST_RESPONSE_TIME
+ * The response time (in milliseconds) a chunk request should not exceed in
+ * adaptive mode. Chunks answered in less than half of that time let the chunk
+ * size grow, slower answers make it shrink.
+ * Can be overridden per gallery by the setting 'ItemChunkResponseTime'.
+ */
+#define ITEM_LIST_RESPONSE_TIME 2000
+
+/*!
+ * @config ITEM_LIST_URL_LENGTH
+ * The maximum length of a request url when chunks are requested by http get.
+ * Many web servers reject longer urls, so longer chunks are either cut or
+ * tunnelled as a http post request.
+ * Can be overridden per gallery by the setting 'ItemChunkUrlLength'.
+ */
+#define ITEM_LIST_URL_LENGTH 2000
+
+/*!
+ * @config ITEM_LIST_PAGE_SIZE
+ * Albums holding more members than this are listed page by page: the member
+ * urls are requested in windows of this size and each window is published
+ * before the next one is requested. A value of 0 disables paging.
+ * Can be overridden per gallery by the setting 'ItemPageSize'.
+ */
+#define ITEM_LIST_PAGE_SIZE 500
+
+/*!
+ * @config ITEM_LIST_BATCH_SIZE
+ * Entries of a directory listing are handed over to the calling scope in
+ * batches of this size instead of one by one.
+ * Can be overridden per gallery by the setting 'ListBatchSize'.
+ */
+#define ITEM_LIST_BATCH_SIZE 200
+
+/*!
+ * @config ITEM_LIST_BATCH_INTERVAL
+ * Maximum time in milliseconds an entry of a directory listing is held back
+ * waiting for its batch to be filled.
+ * Can be overridden per gallery by the setting 'ListBatchInterval'.
+ */
+#define ITEM_LIST_BATCH_INTERVAL 250
+
+/*!
+ * @config ITEM_MISSING_NAMES
+ * Maximum number of names an album remembers as not existing, so repeated
+ * lookups of names like '.directory' do not have to ask the remote system.
+ */
+#define ITEM_MISSING_NAMES 64
+
+/*!
+ * @config ITEM_PATH_MEMO
+ * Maximum number of resolved paths a backend remembers, so paths requested
+ * again and again do not have to be walked down from the base item.
+ */
+#define ITEM_PATH_MEMO 1024
+
+/*!
+ * @config ITEM_MEMORY_BUDGET
+ * Memory in kilobytes the items of a backend may roughly occupy before the
+ * members of the least recently used albums are evicted, 0 means unlimited.
+ */
+#define ITEM_MEMORY_BUDGET 32768
+
+/*!
+ * @config ITEM_TTL_ALBUM
+ * The time (in seconds) an album kept in memory is used before it is
+ * revalidated, after the command using it has been answered, 0 disables the
+ * revalidation. Can be overridden by the setting 'ItemTTLAlbum'.
+ */
+#define ITEM_TTL_ALBUM 300
+
+/*!
+ * @config ITEM_TTL_FILE
+ * Like ITEM_TTL_ALBUM, but for all other items, photos and movies can be
+ * overridden by the settings 'ItemTTLPhoto' and 'ItemTTLMovie'.
+ */
+#define ITEM_TTL_FILE 1800
+
+/*!
+ * @config ITEM_REVALIDATE_IDLE
+ * The time (in seconds) a slave has to be idle before the items used by the
+ * last commands are revalidated. Revalidation proceeds in steps, each command
+ * postpones the next step again.
+ */
+#define ITEM_REVALIDATE_IDLE 1
+
+/*!
+ * @config ITEM_REVALIDATE_STEP
+ * Number of items revalidated at most in one step, so the slave can answer
+ * the next command without waiting for a large revalidation to complete.
+ */
+#define ITEM_REVALIDATE_STEP 100
+
+/*!
+ * @config REQUEST_CONCURRENCY
+ * The maximum number of requests kept in flight at the same time against a
+ * single remote Gallery3 system. Chunks of items are retrieved in parallel up
+ * to this limit, which hides the latency of slow network links.
+ * Can be overridden per gallery by the setting 'RequestConcurrency'.
+ */
+#define REQUEST_CONCURRENCY 4
+
+/*!
+ * @config UPLOAD_CHUNK_SIZE
+ * The maximum number of bytes of a file read at once when it is uploaded.
+ * Files are streamed, so this limits the memory required for an upload.
+ */
+#define UPLOAD_CHUNK_SIZE 65536
+
+/*!
+ * @config ITEM_CACHE_TTL
+ * The time (in seconds) the description of an item is taken from the local
+ * cache file without asking the remote Gallery3 system again. Older records
+ * are revalidated the next time the item is required.
+ * The cache can be disabled per gallery by the setting 'ItemCache', the time
+ * can be overridden by the setting 'ItemCacheTTL'.
+ */
+#define ITEM_CACHE_TTL 3600
+
+/*!
+ * @config ITEM_CACHE_FLUSH
+ * The time (in seconds) a slave has to be idle before changed records are
+ * written to the cache file. Apart from that the cache file is written when a
+ * slave terminates.
+ */
+#define ITEM_CACHE_FLUSH 10
+
+/*!
+ * @config ITEM_CACHE_SERVICE_TIMEOUT
+ * The time (in milliseconds) a slave waits for the shared cache service
+ * before it continues on its own. The service can be disabled per gallery by
+ * the setting 'ItemCacheService'.
+ */
+#define ITEM_CACHE_SERVICE_TIMEOUT 250
+
+/*!
+ * @config ITEM_CACHE_SERVICE_IDLE
+ * The time (in seconds) the shared cache service keeps running after the
+ * last slave has disconnected.
+ */
+#define ITEM_CACHE_SERVICE_IDLE 600
+
+/*!
+ * @config ITEM_CACHE_SERVICE_RECORDS
+ * Maximum number of records the shared cache service keeps in memory, for
+ * all galleries together. When exceeded the least recently used quarter of
+ * the records is dropped.
+ */
+#define ITEM_CACHE_SERVICE_RECORDS 65536
+
+/*!
+ * @config ITEM_TABLE_DENSE_LIMIT
+ * Items with an id below this limit might be registered in a plain vector
+ * indexed by the id, items with larger ids are always kept in a hash.
+ */
+#define ITEM_TABLE_DENSE_LIMIT 4194304
+
+/*!
+ * @config ITEM_TABLE_DENSE_FILL
+ * The vector registering items by their id only grows as long as it holds at
+ * least one item per this number of slots, other items are kept in a hash.
+ */
+#define ITEM_TABLE_DENSE_FILL 4
+
+/*!
+ * @config POOL_BLOCK_SIZE
+ * Number of objects allocated at once by a pool, see class Pool.
+ */
+#define POOL_BLOCK_SIZE 256
+
+/*!
+ * @typedef quint32 g3index
  * We use a local identifier to describe the type of an item id.
  * The idea is to have a clear distinction between ordinary integers like
  * iterators or array indices and item ids. 
- * @todo check the size used inside the server side gallery3 code: what field type does the id have inside mysql there ?
+ * Gallery3 stores item ids as unsigned 32 bit integers inside its database,
+ * a smaller type would wrap in large galleries.
  */
-typedef quint16 g3index;
+typedef quint32 g3index;
 
 /*!
  * @define MIN
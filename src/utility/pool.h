@@ -0,0 +1,93 @@
+/* This file is part of 'kio-gallery3'
+ * Copyright (C) 2011 Christian Reiner ("arkascha") <kio-gallery3@christian-reiner.info>
+ *
+ * $Author: arkascha $
+ * $Revision: 119 $
+ * $Date: 2011-09-12 09:35:04 +0200 (Mon, 12 Sep 2011) $
+ */
+
+/*!
+ * @file
+ * Defines class template Pool, a simple allocator for objects of fixed size.
+ * The class is a 'header only library', no methods are defined in an
+ * additional .cpp file, so no linkage is required.
+ * @see Pool
+ * @author Christian Reiner
+ */
+
+#ifndef UTILITY_POOL_H
+#define UTILITY_POOL_H
+
+#include <new>
+#include <QList>
+#include "utility/defines.h"
+
+namespace KIO
+{
+  namespace Gallery3
+  {
+
+    /*!
+     * @class Pool
+     * @brief Allocator handing out memory for objects of class T
+     * Memory is allocated in blocks of POOL_BLOCK_SIZE objects. Released slots
+     * are kept in a free list and handed out again, so constructing and
+     * destroying many objects does not involve the heap each time. The blocks
+     * are only returned to the heap when the pool itself is destroyed.
+     * Typically used by a class T defining its own operators 'new' and 'delete'.
+     * Note that the pool is not thread safe, a slave processes one command at a time.
+     * This is a header-only implementation, no source or object file has to be be considered.
+     * @author Christian Reiner
+     */
+    template<typename T>
+    class Pool
+    {
+      private:
+        struct Slot { Slot* next; };
+        // size of a slot, large enough for both, an object and a link, aligned to 8 bytes
+        enum { SIZE = ( ( sizeof(T)>sizeof(Slot) ? sizeof(T) : sizeof(Slot) ) + 7 ) & ~7 };
+        QList<char*> m_blocks;
+        Slot*        m_free;
+        int          m_count;
+        inline void grow ( )
+        {
+          char* block = static_cast<char*> ( ::operator new(POOL_BLOCK_SIZE*SIZE) );
+          m_blocks << block;
+          for ( int pos=POOL_BLOCK_SIZE-1; pos>=0; pos-- )
+          {
+            Slot* slot = reinterpret_cast<Slot*> ( block+pos*SIZE );
+            slot->next = m_free;
+            m_free     = slot;
+          }
+        }
+      public:
+        inline Pool  ( ) : m_free(NULL), m_count(0) { }
+        inline ~Pool ( ) { foreach ( char* block, m_blocks ) ::operator delete ( block ); }
+        // number of objects currently handed out
+        inline int count ( ) const { return m_count; }
+        // number of bytes allocated from the heap
+        inline int size  ( ) const { return m_blocks.count() * POOL_BLOCK_SIZE * SIZE; }
+        inline void* allocate ( )
+        {
+          if ( NULL==m_free )
+            grow ( );
+          Slot* slot = m_free;
+          m_free = slot->next;
+          m_count++;
+          return slot;
+        }
+        inline void release ( void* pointer )
+        {
+          if ( NULL==pointer )
+            return;
+          Slot* slot = static_cast<Slot*> ( pointer );
+          slot->next = m_free;
+          m_free     = slot;
+          m_count--;
+        }
+    }; // class Pool
+
+  } // namespace Gallery3
+} // namespace KIO
+
+#endif // UTILITY_POOL_H